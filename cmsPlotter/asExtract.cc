@@ -0,0 +1,160 @@
+//Implementation of the alphaS extraction of asExtract.h, part of libAsFitter.so
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <thread>
+
+#include "asExtract.h"
+
+std::vector<double> solveQuadratic(double a, double b, double c)
+{
+    double sc = std::abs(a) + std::abs(b) + std::abs(c);
+    if(sc == 0) return {};
+    if(std::abs(a) < 1e-14*sc) {
+        if(std::abs(b) < 1e-14*sc) return {};
+        return {-c/b};
+    }
+    double disc = b*b - 4*a*c;
+    if(disc < 0) return {};
+    double q = -0.5*(b + (b >= 0 ? 1 : -1)*sqrt(disc)); //stable form
+    std::vector<double> r = {q/a};
+    if(q != 0) r.push_back(c/q);
+    return r;
+}
+
+std::vector<double> solveCubic(double a, double b, double c, double d)
+{
+    double sc = std::abs(a) + std::abs(b) + std::abs(c) + std::abs(d);
+    if(sc == 0 || std::abs(a) < 1e-14*sc) return solveQuadratic(b, c, d);
+    b /= a; c /= a; d /= a;
+    double q = (3*c - b*b) / 9;
+    double r = (9*b*c - 27*d - 2*b*b*b) / 54;
+    double disc = q*q*q + r*r;
+    double shift = b / 3;
+    if(disc >= 0) {
+        double s = cbrt(r + sqrt(disc));
+        double u = cbrt(r - sqrt(disc));
+        return {s + u - shift};
+    }
+    double theta = acos(std::max(-1., std::min(1., r / sqrt(-q*q*q))));
+    double m = 2*sqrt(-q);
+    return {m*cos(theta/3) - shift, m*cos((theta + 2*M_PI)/3) - shift, m*cos((theta + 4*M_PI)/3) - shift};
+}
+
+
+asFitResult fitAsPol4(const double *x, const double *y, int n)
+{
+    asFitResult res;
+    if(n < 2) return res;
+
+    double xMin = *std::min_element(x, x+n);
+    double xMax = *std::max_element(x, x+n);
+    res.x0 = (xMin + xMax) / 2;
+    res.h  = (xMax - xMin) / 2;
+    if(res.h <= 0) return res;
+    int deg = std::min(4, n-1);
+    int m = deg + 1;
+
+    //normal equations
+    double A[5][6] = {};
+    for(int i = 0; i < n; ++i) {
+        double t = (x[i] - res.x0) / res.h;
+        double pw[9];
+        pw[0] = 1;
+        for(int k = 1; k < 2*m-1; ++k) pw[k] = pw[k-1]*t;
+        for(int j = 0; j < m; ++j) {
+            for(int k = 0; k < m; ++k)
+                A[j][k] += pw[j+k];
+            A[j][m] += pw[j]*y[i];
+        }
+    }
+    //Gauss elimination with partial pivoting
+    for(int j = 0; j < m; ++j) {
+        int piv = j;
+        for(int k = j+1; k < m; ++k)
+            if(std::abs(A[k][j]) > std::abs(A[piv][j])) piv = k;
+        for(int l = 0; l <= m; ++l) std::swap(A[j][l], A[piv][l]);
+        if(A[j][j] == 0) return res;
+        for(int k = j+1; k < m; ++k) {
+            double f = A[k][j] / A[j][j];
+            for(int l = j; l <= m; ++l) A[k][l] -= f*A[j][l];
+        }
+    }
+    for(int j = m-1; j >= 0; --j) {
+        double s = A[j][m];
+        for(int l = j+1; l < m; ++l) s -= A[j][l]*res.c[l];
+        res.c[j] = s / A[j][j];
+    }
+
+    //stationary points
+    std::vector<double> stat = solveCubic(4*res.c[4], 3*res.c[3], 2*res.c[2], res.c[1]);
+    std::sort(stat.begin(), stat.end());
+
+    //minimum within the scan
+    double tMin = -1;
+    for(double t : {-1., 1.})
+        if(res.evalT(t) < res.evalT(tMin)) tMin = t;
+    for(double t : stat)
+        if(t > -1 && t < 1 && res.evalT(t) < res.evalT(tMin)) tMin = t;
+    double target = res.evalT(tMin) + 1;
+
+    //crossing of the target in [a, b], where the polynomial is monotonic
+    auto cross = [&](double a, double b, double &tc) {
+        double fa = res.evalT(a) - target, fb = res.evalT(b) - target;
+        if(fa*fb > 0) return false;
+        for(int it = 0; it < 100 && std::abs(b - a) > 1e-13; ++it) {
+            double tm = 0.5*(a + b);
+            double fm = res.evalT(tm) - target;
+            if((fm < 0) == (fa < 0)) { a = tm; fa = fm; }
+            else                     { b = tm; fb = fm; }
+        }
+        tc = 0.5*(a + b);
+        return true;
+    };
+
+    //go from the minimum to both sides, the stationary points split the path to monotonic intervals
+    auto search = [&](double from, double to, double &tc) {
+        std::vector<double> pts = {from};
+        for(double t : stat)
+            if((t - from)*(to - t) > 0) pts.push_back(t);
+        pts.push_back(to);
+        if(to < from) std::sort(pts.rbegin(), pts.rend());
+        else          std::sort(pts.begin(), pts.end());
+        for(int i = 0; i+1 < pts.size(); ++i)
+            if(cross(pts[i], pts[i+1], tc)) return true;
+        tc = to;
+        return false;
+    };
+
+    double tUp, tDn;
+    bool okUp = search(tMin,  3., tUp);
+    bool okDn = search(tMin, -3., tDn);
+
+    res.asMin   = res.x0 + res.h*tMin;
+    res.chi2Min = target - 1;
+    res.errUp   = res.h*(tUp - tMin);
+    res.errDn   = res.h*(tMin - tDn);
+    res.ok      = okUp && okDn;
+    return res;
+}
+
+asFitResult fitAsPol4(const std::vector<double> &x, const std::vector<double> &y)
+{
+    return fitAsPol4(x.data(), y.data(), std::min(x.size(), y.size()));
+}
+
+std::vector<asFitResult> fitAsBatch(const std::vector<std::vector<double>> &xs, const std::vector<std::vector<double>> &ys, int nThreads)
+{
+    std::vector<asFitResult> res(xs.size());
+    if(nThreads <= 0) nThreads = std::max(1u, std::thread::hardware_concurrency());
+    nThreads = std::max(1, std::min<int>(nThreads, xs.size()));
+
+    std::vector<std::thread> threads;
+    for(int th = 0; th < nThreads; ++th)
+        threads.emplace_back([&, th]() {
+            for(int i = th; i < xs.size(); i += nThreads)
+                res[i] = fitAsPol4(xs[i], ys[i]);
+        });
+    for(auto &t : threads) t.join();
+    return res;
+}
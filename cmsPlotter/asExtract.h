@@ -0,0 +1,52 @@
+#ifndef asExtract_H
+#define asExtract_H
+
+#include <vector>
+
+#include "TF1.h"
+#include "TString.h"
+
+//Closed-form extraction of alphaS from a chi2 scan
+//The chi2 curve is fitted by pol4 in the scaled variable t = (as - x0)/h, where the scan covers t in [-1,1].
+//It is a linear least squares problem solved by the small normal equations (no iterative fit).
+//The minimum is taken from the analytic roots of the derivative (cubic), the dChi2 = 1 crossings are found
+//in the monotonic intervals between the stationary points, the search extends one scan width beyond the scan.
+//The fits are compiled to libAsFitter.so (asExtract.cc).
+
+struct asFitResult {
+    double asMin = 0, chi2Min = 0, errUp = 0, errDn = 0;
+    double c[5] = {0, 0, 0, 0, 0}; //coefficients in t
+    double x0 = 0, h = 1;
+    bool ok = false; //false if the curve has no crossing within the search range
+
+    double evalT(double t) const { return c[0] + t*(c[1] + t*(c[2] + t*(c[3] + t*c[4]))); }
+    double eval(double as) const { return evalT((as - x0) / h); }
+};
+
+
+//Real roots of a t^2 + b t + c = 0 (also for a = 0)
+std::vector<double> solveQuadratic(double a, double b, double c);
+
+//Real roots of a t^3 + b t^2 + c t + d = 0 (Cardano, trigonometric form for three real roots)
+std::vector<double> solveCubic(double a, double b, double c, double d);
+
+//Fit of the n points (x = alphaS, y = chi2), pol4 or lower degree if there are less than 5 points
+asFitResult fitAsPol4(const double *x, const double *y, int n);
+asFitResult fitAsPol4(const std::vector<double> &x, const std::vector<double> &y);
+
+//Fits of many scans, distributed over nThreads threads (all cores for nThreads <= 0)
+std::vector<asFitResult> fitAsBatch(const std::vector<std::vector<double>> &xs, const std::vector<std::vector<double>> &ys, int nThreads = 0);
+
+//TF1 with the fitted polynomial, e.g. for drawing
+inline TF1 *getAsFitFunction(const asFitResult &r, double xMin = 0.1, double xMax = 0.13)
+{
+    TF1 *f = new TF1(Form("asFit%d", rand()), "[0] + [1]*((x-[5])/[6]) + [2]*pow((x-[5])/[6],2) + [3]*pow((x-[5])/[6],3) + [4]*pow((x-[5])/[6],4)", xMin, xMax);
+    for(int i = 0; i < 5; ++i)
+        f->SetParameter(i, r.c[i]);
+    f->SetParameter(5, r.x0);
+    f->SetParameter(6, r.h);
+    return f;
+}
+
+
+#endif
@@ -0,0 +1,2579 @@
+//Implementation of asFitter (see asFitter.h), compiled with full optimisation to libAsFitter.so
+#include <fstream>
+#include <sstream>
+#include <set>
+#include <iomanip>
+#include <string>
+#include <cmath>
+#include <cstdlib>
+#include <cfloat>
+#include <stdexcept>
+
+#include "TFile.h"
+#include "TCanvas.h"
+#include "TStyle.h"
+#include "TDecompSVD.h"
+#include "TDecompChol.h"
+#include "TMatrixDSym.h"
+#include "TMatrixDSymEigen.h"
+#include "Math/Functions.h"
+#include "TF1.h"
+#include "TNamed.h"
+
+#include "plottingHelper.h"
+using namespace PlottingHelper;
+
+#include "asFitter.h"
+#include "instrument.h"
+
+/*
+const vector<TString> ErrNames = {
+"nperr", "lumi", "AbsoluteStat",  "AbsoluteScale",  "AbsoluteMPFBias",  "Fragmentation",  "SinglePionECAL",  "SinglePionHCAL",  "FlavorQCD",  "TimePtEta",  "RelativeJEREC1",  "RelativeJEREC2",  "RelativeJERHF",  "RelativePtBB",  "RelativePtEC1",  "RelativePtEC2", "RelativePtHF",  "RelativeBal",  "RelativeSample",  "RelativeFSR",  "RelativeStatFSR",  "RelativeStatEC",  "RelativeStatHF",  "PileUpDataMC",  "PileUpPtRef",  "PileUpPtBB",  "PileUpPtEC1",  "PileUpPtEC2",  "PileUpPtHF",  "fake",  "miss",  "JER",  "PUprof"};
+*/
+
+vector<TString> ErrNames = {
+"NPerr", "NPsh", "Lumi", "AbsStat",  "AbsScale",  "AbsMPFBias",  "Frag",  "SinglePionECAL",  "SinglePionHCAL",  "FlavorQCD",  "TimePtEta",  "RelJEREC1",  "RelJEREC2",  "RelJERHF",  "RelPtBB",  "RelPtEC1",  "RelPtEC2", "RelPtHF",  "RelBal",  "RelSample",  "RelFSR",  "RelStatFSR",  "RelStatEC",  "RelStatHF",  "PUDataMC",  "PUPtRef",  "PUPtBB",  "PUPtEC1",  "PUPtEC2",  "PUPtHF",  "fake",  "miss",  "JER",  "PUprof"};
+
+const vector<TString> ErrNamesTable = ErrNames; //sources as in the data tables
+
+
+static TString rn() {return Form("%d",rand());}
+
+
+//__________________________________________________________________________________________________________________________________
+
+
+vector<point>  asFitter::readData(TString fName, double unCorr)
+{
+    vector<point> dataNow;
+
+    ifstream infile(fName);
+    if(!infile.good()) {
+        cout << "File " << fName <<" does not exist." << endl;
+        exit(1);
+    }
+    string line;
+    bool isIn = false;
+    while (getline(infile, line))
+    {
+        if(line.size() < 5 && line[0] == '*') {
+            isIn = true;
+            continue;
+        }
+        if(!isIn) continue;
+
+        istringstream iss(line);
+        //cout << "Line size " << line.size() << endl;
+        point p;
+        double flag, nPerL, nPerH, lumi;
+        iss >> flag >> p.yMin >> p.yMax >> p.ptMin >> p.ptMax >> p.sigma >> p.errStat >> p.errUnc;
+        p.errStat /= 100;
+        p.errUnc  /= 100;
+
+        //p.sigma *= 0.97; //RADEK test
+
+        //if(abs(p.yMin - 0) < 0.1) //first y-bin 0.5% //RADEK change
+
+        p.errStat = sqrt(pow(p.errStat,2) - pow(p.errUnc,2)); //hack for now, to correct the bug
+        p.errUncOrg = p.errUnc;
+
+        if(unCorr > 0)
+            p.errUnc = unCorr/100; //3% ? RADEK
+
+        iss >> nPerL >> nPerH;
+        p.errs.push_back((nPerL-nPerH)/2);
+
+        iss >> nPerL >> nPerH; //for sherpa NP uncs
+        p.errs.push_back((nPerL-nPerH)/2);
+
+        iss >> lumi;
+        p.errs.push_back(lumi);
+
+        p.th = 0;
+
+        double a, b;
+        while ((iss >> a >> b)) {  //pushing all error sources
+            p.errs.push_back( (a - b)/2 );
+            //cout << a << " " << b << " ";
+        } // error
+        for(auto & e : p.errs) { //and dividing them by 100
+            e /= 100;
+        }
+        //p.errs[1] = 0.04; //Radek test
+        //cout << "HelenkaKarel " << p.errs[1] << endl;
+
+        if(p.sigma > 0 && p.errStat < 0.4)
+            dataNow.push_back(p);
+        //cout << endl << endl;;
+        // process pair (a,b)
+    }
+    assert(dataNow.size() > 10);
+    return dataNow;
+
+}
+
+void asFitter::setUnCorr(double unCorr)
+{
+    for(auto &p : data)
+        p.errUnc = hypot((unCorr > 0) ? unCorr/100 : p.errUncOrg, p.errMerged);
+}
+
+void asFitter::Decorrelate(map<TString, vector<int>> decMap)
+{
+    vector<TString> ErrNamesNew;
+    for(int i = 0; i < ErrNames.size(); ++i) {
+        if(!decMap.count(ErrNames[i])) {
+            ErrNamesNew.push_back(ErrNames[i]);
+            continue;
+        }
+        else { //do decorelation
+            auto v = decMap.at(ErrNames[i]);
+            map<int,TString> names;
+            for(int y = 0; y < 4; ++y) {
+                names[v[y]] += Form("%d",y);
+            }
+            for(auto n : names) {
+                //cout <<"Radek " <<  n.first <<" "<< n.second << endl;
+                ErrNamesNew.push_back(ErrNames[i] + Form("_y%s", n.second.Data()));
+            }
+        }
+    }
+
+    //Print to veryfy
+    for(auto n : ErrNamesNew)
+        cout << n << " ";
+    cout << endl;
+
+
+    vector<vector<double>> errsNowAll(data.size());
+    for(int i = 0; i < data.size(); ++i) {
+        auto &p = data[i];
+        vector<double> errsNow; 
+
+        //Loop over new error names
+        for(auto n : ErrNamesNew) {
+            TString nRaw = n;
+            TString nDec;
+            if(nRaw.Contains('_')) {
+                nRaw = nRaw(0, nRaw.First('_'));
+                nDec = n(n.First('_')+2, 10000);
+                cout << "Radek " << nRaw << " "<< nDec << " "<< n << endl;
+            }
+
+            int idRaw  = find(ErrNames.begin(), ErrNames.end(), nRaw) - ErrNames.begin();
+            assert(idRaw < ErrNames.size());
+            double val = p.errs[idRaw];
+            if(nDec.Length() > 0) { //if decorelation
+                int y = round(p.yMin * 2);
+                if(!nDec.Contains(Form("%d",y)))
+                    val = 0;
+                cout << "Helenka " << n <<" "<< p.yMin << " "<< val << endl;
+            }
+            errsNow.push_back(val);
+        } 
+        errsNowAll[i] = errsNow;
+    }
+
+    //Replacing errors
+    for(int i = 0; i < data.size(); ++i) {
+        data[i].errs = errsNowAll[i];
+    }
+    //Replacing the names
+    ErrNames = ErrNamesNew;
+}
+
+bool asFitter::parseDecMap(TString dec, map<TString, vector<int>> &decMap)
+{
+    decMap.clear();
+    if(dec == "default") {
+        decMap = { {"NPerr",{1,2,3,4}},  {"NPsh",{1,2,3,4}},   {"RelFSR", {1,1,1,2}}, /*  {"JER", {1,2,3,4}},*/   /*{"RelSample", {1,1,2,2}},*/ /*  {"fake", {1,2,3,4}},*/  {"miss", {1,2,3,4}}   };
+        return true;
+    }
+    if(dec == "none") return true;
+    for(auto item : splitString(dec, ';')) {
+        int c = item.First(':');
+        vector<int> groups;
+        if(c > 0)
+            for(auto g : splitString(item(c+1, item.Length()), ','))
+                groups.push_back(g.Atoi());
+        if(groups.size() != 4) return false;
+        decMap[item(0, c)] = groups;
+    }
+    return true;
+}
+
+void asFitter::addDataset(TString tag, TString fName, TString thFile, double unCorr, map<TString, vector<int>> decMap, vector<TString> shared)
+{
+    ErrNames = ErrNamesTable;
+    data = readData(fName, unCorr);
+    Decorrelate(decMap);
+
+    dataset ds;
+    ds.tag    = tag;
+    ds.names  = ErrNames;
+    ds.points = data;
+    sets.push_back(ds);
+
+    for(auto s : shared)
+        if(find(sharedSources.begin(), sharedSources.end(), s) == sharedSources.end())
+            sharedSources.push_back(s);
+
+    if(!thSources.count(tag))
+        setTheory(tag, thFile);
+
+    buildJoint();
+}
+
+void asFitter::buildJoint()
+{
+    auto isShared = [&](TString n) {
+        TString nRaw = n.Contains('_') ? TString(n(0, n.First('_'))) : n;
+        return find(sharedSources.begin(), sharedSources.end(), nRaw) != sharedSources.end();
+    };
+
+    vector<TString> names, namesShared;
+    for(const auto &ds : sets)
+        for(auto n : ds.names) {
+            if(!isShared(n))
+                names.push_back(n + "@" + ds.tag);
+            else if(find(namesShared.begin(), namesShared.end(), n) == namesShared.end())
+                namesShared.push_back(n);
+        }
+    names.insert(names.end(), namesShared.begin(), namesShared.end());
+
+    data.clear();
+    for(auto &ds : sets) {
+        //local source -> global one
+        vector<int> glob;
+        for(auto n : ds.names) {
+            TString nG = isShared(n) ? n : n + "@" + ds.tag;
+            glob.push_back(find(names.begin(), names.end(), nG) - names.begin());
+        }
+
+        ds.first = data.size();
+        for(auto p : ds.points) {
+            vector<double> errs(names.size(), 0.);
+            for(int j = 0; j < glob.size(); ++j)
+                errs[glob[j]] = p.errs[j];
+            p.errs = errs;
+            data.push_back(p);
+        }
+        ds.last = data.size();
+    }
+    ErrNames = names;
+    binJoins.clear();
+    ws.nErr = -1; //the solver buffers and blocks are set up again
+
+    cout << "Joint fit of " << sets.size() << " datasets, " << data.size() << " points, "
+         << namesShared.size() << " shared and " << names.size() - namesShared.size() << " specific sources" << endl;
+}
+
+vector<TH1D*> asFitter::readMember(TString pdfName, double as, int s, int ipdf, TString tag)
+{
+    vector<TH1D*> vTh;  //indexes - [y]
+    {
+        INSTR_SCOPE("theoryRead");
+        vTh = getSource().read(pdfName, as, s, ipdf);
+    }
+    if(vTh.size() != 5) {
+        fail("Theory of " + pdfName + Form(" as=%g scale%d pdf%d", as, s, ipdf) + " not available");
+    }
+    if(tag != "") {
+        INSTR_SCOPE("corrections");
+        for(int y = 0; y < 5; ++y)
+            applyNPEW(vTh[y], y, tag);
+    }
+    return vTh;
+}
+
+vector<double> asFitter::getKfactors(const theoryStore &st, TString tag, TString order)
+{
+    //NLO needs no k-factors, e.g. the synthetic theory of benchFitter has no jet radius in its tag
+    vector<double> kFac(st.nBinsTot(), 1.);
+    if(!order.Contains("nll") && !order.Contains("nnlo"))
+        return kFac;
+
+    TString tagN;
+    if(tag.Contains("ak4")) tagN = "_ak4";
+    else if(tag.Contains("ak7")) tagN = "_ak7";
+    else {
+        fail("No jet radius in the tag " + tag + ", the " + order + " k-factors cannot be applied");
+    }
+
+    for(int y = 0; y < st.nY(); ++y) {
+        int nB = st.yOff[y+1] - st.yOff[y];
+        TH1D *h = new TH1D(rn(), "", nB, st.edges.data() + st.yOff[y] + y);
+        for(int i = 1; i <= nB; ++i)
+            h->SetBinContent(i, 1);
+
+        if(order.Contains("nll")) applyKfactor(h, y, "kFactorNLL"+tagN);
+        else                      applyKfactor(h, y, "kFactorNNLO"+tagN);
+
+        for(int i = 1; i <= nB; ++i)
+            kFac[st.yOff[y]+i-1] = h->GetBinContent(i);
+        delete h;
+    }
+    return kFac;
+}
+
+void asFitter::fail(TString msg)
+{
+    if(!throwOnError())
+        for(auto key : pendingStores) //the filling is not finished (with the throw openStore removes them)
+            theoryStore::remove(key);
+    fatalError(msg);
+}
+
+void asFitter::dropTheory(TString pdfName, TString tag)
+{
+    TString thK = thKey(pdfName, tag);
+    thStores.erase(thK);
+    pdfDeltas.erase(thK);
+    thSplines.erase(thK);
+    binJoins.erase(thK);
+    pdfErrTypes.erase(pdfName);
+}
+
+set<TString> asFitter::pendingStores;
+
+void asFitter::openStore(theoryStore &st, TString key, TString srcId, function<void()> setLayout, function<void()> fill)
+{
+    st.srcId = srcId.Hash();
+    if(key != "" && st.attach(key)) {
+        cout << "Theory attached to " << key << endl;
+        return;
+    }
+
+    setLayout();
+
+    bool isPublisher = false;
+    if(key != "") {
+        isPublisher = st.create(key);
+        if(!isPublisher) { //somebody else was faster
+            if(!st.attach(key)) {
+                fail("Theory store " + key + " can be neither created nor attached");
+            }
+            cout << "Theory attached to " << key << endl;
+            return;
+        }
+    }
+    else {
+        st.allocate();
+    }
+
+    if(isPublisher) pendingStores.insert(key);
+    try {
+        fill();
+    }
+    catch(...) { //unfinished block would keep the other processes waiting
+        if(isPublisher) {
+            theoryStore::remove(key);
+            pendingStores.erase(key);
+        }
+        throw;
+    }
+
+    if(isPublisher) {
+        st.publish();
+        pendingStores.erase(key);
+        cout << "Theory published to " << key << endl;
+    }
+}
+
+TString asFitter::thKey(TString pdfName, TString tag) const
+{
+    return (thTag == "" || tag == thTag) ? pdfName : pdfName + "@" + tag;
+}
+
+void asFitter::setTheory(TString tag, TString spec)
+{
+    thSources[tag] = makeTheorySource(spec, tag);
+    thSrcIds[tag] = theorySourceId(spec);
+    if(!thSrc) {
+        thSrc = thSources.at(tag);
+        thSrcId = thSrcIds.at(tag);
+    }
+}
+
+void asFitter::useTheory(TString tag)
+{
+    if(thSources.count(tag)) {
+        thSrc = thSources.at(tag);
+        thSrcId = thSrcIds.at(tag);
+    }
+}
+
+theorySource &asFitter::getSource()
+{
+    if(!thSrc) {
+        fail("No theory source, set it by setTheory");
+    }
+    return *thSrc;
+}
+
+void asFitter::loadTheory(TString pdfName, TString tag, vector<double> asList, int nScl, TString shmKey)
+{
+    if(thTag == "") thTag = tag;
+    thShmKey = shmKey;
+    useTheory(tag);
+    TString thK = thKey(pdfName, tag);
+    theoryStore &st = thStores[thK];
+    binJoins.erase(thK);
+    pdfDeltas.erase(thK);
+    thSplines.erase(thK);
+
+    //the central predictions contain the NP/EW corrections
+    TString srcId = thSrcId + "|" + fileStamp(corrFileName());
+    TString key = shmKey != "" ? shmKey + "_" + pdfName + "_" + tag + Form("_nom_s%d_%08x", nScl, srcId.Hash()) : "";
+
+    openStore(st, key, srcId,
+    [&]() {
+        //binning from the nominal histograms
+        vector<TH1D*> hBins = readMember(pdfName, asList[0], 0, 0);
+        st.setLayout(asList, vector<int>(asList.size(), 1), nScl, hBins);
+        for(auto h : hBins) delete h;
+    },
+    [&]() {
+        for(int iAs = 0; iAs < asList.size(); ++iAs) {
+            cout << pdfName <<" "<< asList[iAs] << endl;
+            for(int s = 0; s < nScl; ++s) {
+                auto vTh = readMember(pdfName, asList[iAs], s, 0, tag);
+                st.fill(iAs, s, 0, vTh);
+                for(auto h : vTh) delete h;
+            }
+        }
+    });
+}
+
+const asSpline &asFitter::getAsSpline(TString thK, int scale)
+{
+    const theoryStore &st = thStores.at(thK);
+    vector<asSpline> &spl = thSplines[thK];
+    if(spl.empty()) spl.resize(st.nScl);
+    if(spl[scale].nB == 0) {
+        vector<double> vals;
+        for(int iAs = 0; iAs < st.asVals.size(); ++iAs)
+            for(int b = 0; b < st.nBinsTot(); ++b)
+                vals.push_back(st.get(iAs, scale, 0, b));
+        spl[scale].init(st.asVals, vals);
+    }
+    return spl[scale];
+}
+
+vector<double> asFitter::getAsScan(TString pdfName) const
+{
+    const vector<double> &asVals = pdfAsVals.at(pdfName);
+    if(asStep <= 0) return asVals;
+    return getRange(asVals.front(), asVals.back(), asStep);
+}
+
+const pdfErrType &asFitter::getPdfErrType(TString pdfName)
+{
+    if(!pdfErrTypes.count(pdfName)) {
+        TString info = getSource().getErrType(pdfName);
+        if(info != "") pdfErrTypes[pdfName] = pdfErrType::fromString(info);
+        else           pdfErrTypes[pdfName] = pdfErrType::fromName(pdfName, getSource().getNmembers(pdfName, 0.118));
+        cout << pdfName << " pdf uncertainty: " << pdfErrTypes.at(pdfName).toString() << endl;
+    }
+    return pdfErrTypes.at(pdfName);
+}
+
+const theoryStore &asFitter::loadPdfDeltas(TString pdfName, TString tag)
+{
+    TString thK = thKey(pdfName, tag);
+    if(pdfDeltas.count(thK))
+        return pdfDeltas.at(thK);
+
+    useTheory(tag);
+    const theoryStore &nom = thStores.at(thK);
+    theoryStore &st = pdfDeltas[thK];
+    int nScl = pdfShareScales ? 1 : nom.nScl;
+    int nMem = getPdfErrType(pdfName).nCore + 1;
+
+    TString key = thShmKey != "" ? thShmKey + "_" + pdfName + "_" + tag + Form("_pdf_s%d_%08x", nScl, thSrcId.Hash()) : "";
+
+    openStore(st, key, thSrcId,
+    [&]() {
+        st.setLayout({0.118}, {nMem-1}, nScl, nom);
+    },
+    [&]() {
+        cout << pdfName << " pdf variations" << endl;
+        for(int s = 0; s < nScl; ++s) {
+            auto vNom = readMember(pdfName, 0.118, s, 0);
+            for(int ipdf = 1; ipdf < nMem; ++ipdf) {
+                auto vTh = readMember(pdfName, 0.118, s, ipdf);
+                for(int y = 0; y < vTh.size(); ++y)
+                    for(int i = 1; i <= vTh[y]->GetNbinsX(); ++i) {
+                        double thNom = vNom[y]->GetBinContent(i);
+                        double diff  = thNom != 0 ? (vTh[y]->GetBinContent(i) - thNom) / thNom : 0;
+                        vTh[y]->SetBinContent(i, diff);
+                    }
+                st.fill(0, s, ipdf-1, vTh);
+                for(auto h : vTh) delete h;
+            }
+            for(auto h : vNom) delete h;
+        }
+    });
+    return st;
+}
+
+void asFitter::readAllTheory(TString pdfName, TString tag, TString shmKey) {
+    loadTheory(pdfName, tag, pdfAsVals.at(pdfName), 7, shmKey);
+}
+
+void asFitter::readSingleTheory(TString pdfName, TString tag, TString shmKey) {
+    loadTheory(pdfName, tag, {0.118}, 1, shmKey);
+}
+
+void asFitter::fillTheory(TString pdfName, double as, int scale)
+{
+    //vector<vector<TH1D*>> thHist    = readHistos(pdfName, as);
+    //vector<vector<TH1D*>> thHist118 = readHistos(pdfName, 0.118);
+
+    if(sets.empty())
+        fillTheory(pdfName, thTag, 0, data.size(), as, scale);
+    else
+        for(const auto &ds : sets)
+            fillTheory(pdfName, ds.tag, ds.first, ds.last, as, scale);
+
+    if(pdfCompressTol > 0)
+        compressPDF(pdfCompressTol);
+}
+
+void asFitter::fillTheory(TString pdfName, TString tag, int first, int last, double as, int scale)
+{
+    INSTR_SCOPE("fillTheory");
+    //cout << pdfName <<" "<< as <<" : begin"<< endl;
+    TString thK = thKey(pdfName, tag);
+    const theoryStore &st = thStores.at(thK);
+    //alphaS between the stored values is interpolated
+    int iAs    = st.findAsIndex(as);
+    vector<double> thInt;
+    if(iAs < 0) thInt = getAsSpline(thK, scale).eval(as);
+    //cout << pdfName <<" "<< as <<" : end"<< endl;
+
+    //relative pdf variations, nDel = #members - 1
+    const theoryStore *dl = profilePDF ? &loadPdfDeltas(pdfName, tag) : nullptr;
+    int sPdf = dl && dl->nScl == 1 ? 0 : scale;
+    pdfErrType et = dl ? getPdfErrType(pdfName) : pdfErrType();
+    int nDel = dl ? min(dl->nMem[0], et.nCore) : 0; //the +as members are skipped
+    int nErr = !dl ? 0 : et.type == pdfErrType::hessian ? nDel/2 : nDel;
+    //each symmetric eigenvector is scaled to one sigma, the replicas give the covariance 1/(N-1) sum d d^T
+    double fact = et.type == pdfErrType::replicas ? 1./sqrt(max(1, nDel-1)) : 1./et.getScale();
+
+    TString kK = thKey(order, tag);
+    if(!kFactors.count(kK)) {
+        INSTR_SCOPE("corrections");
+        kFactors[kK] = getKfactors(st, tag, order);
+    }
+    const vector<double> &kFac = kFactors.at(kK);
+
+    //join data points with theory bins (once)
+    vector<int> &join = binJoins[thK];
+    if(join.size() != data.size()) {
+        join.assign(data.size(), -1);
+        for(int i = first; i < last; ++i) {
+            const auto &p = data[i];
+            join[i] = st.findBin(round(p.yMin * 2), (p.ptMin + p.ptMax) / 2.);
+        }
+    }
+
+    for(int i = first; i < last; ++i) {
+        auto &p = data[i];
+        int binId = join[i];
+        p.thErrs.clear();
+        if(binId < 0) { //outside of the theory binning
+            p.th = 0;
+            p.thErrs.resize(nErr, 0.);
+            continue;
+        }
+        p.th = (iAs >= 0 ? st.get(iAs, scale, 0, binId) : thInt[binId]) * kFac[binId];
+        if(!dl) continue;
+
+        //Symetric hessian or MC replicas
+        if(et.type != pdfErrType::hessian) {
+            for(int i = 0; i < nDel; ++i)
+                p.thErrs.push_back(dl->get(0, sPdf, i, binId) * fact);
+        }
+        //Assymetrick hessian - HERAPDF or CT14
+        else {
+            for(int i = 0; i < nErr; ++i) { 
+                double diff = dl->get(0, sPdf, 2*i, binId) - dl->get(0, sPdf, 2*i+1, binId);
+                p.thErrs.push_back(diff/2 * fact);
+            }
+        }
+    }
+}
+
+double asFitter::compressPDF(double tol)
+{
+    int nTh = data[0].thErrs.size();
+    if(nTh == 0) return 0;
+
+    //Gram matrix of the pdf variations over the selected points
+    TMatrixDSym G(nTh);
+    for(const auto &p : data) {
+        if(Cut && !Cut(p)) continue;
+        for(int j = 0; j < nTh; ++j)
+            for(int k = 0; k <= j; ++k)
+                G(j,k) += p.thErrs[j]*p.thErrs[k];
+    }
+    for(int j = 0; j < nTh; ++j)
+        for(int k = 0; k < j; ++k)
+            G(k,j) = G(j,k);
+
+    //eigenvalues are sorted from the largest one
+    TMatrixDSymEigen eigen(G);
+    const TVectorD &lambda = eigen.GetEigenValues();
+    const TMatrixD &V      = eigen.GetEigenVectors();
+
+    double tot = 0;
+    for(int j = 0; j < nTh; ++j)
+        tot += max(0., lambda(j));
+
+    int nKeep = 0;
+    double kept = 0;
+    while(nKeep < nTh && (tot - kept) > tol*tot) {
+        kept += max(0., lambda(nKeep));
+        ++nKeep;
+    }
+    nKeep = max(1, nKeep);
+    double discarded = tot > 0 ? (tot - kept) / tot : 0;
+
+    if(nKeep != nPdfKept)
+        cout << "PDF nuisances compressed " << nTh << " -> " << nKeep << ", discarded variance " << discarded << endl;
+    nPdfKept = nKeep;
+
+    //project all points to the kept components
+    for(auto &p : data) {
+        vector<double> thNew(nKeep, 0.);
+        for(int c = 0; c < nKeep; ++c)
+            for(int j = 0; j < nTh; ++j)
+                thNew[c] += p.thErrs[j] * V(j,c);
+        p.thErrs = thNew;
+    }
+    return discarded;
+}
+
+int asFitter::getNpoints()
+{
+    int s = 0;
+    for(const auto &p : data)
+        s += Cut(p);
+    return s;
+}
+
+double asFitter::getChi2()
+{
+    TVectorD s = getShifts();
+    double chi2 = getChi2(s);
+    
+    //print shifts
+    //for(int i = 0; i < data[0].errs.size(); ++i)
+        //cout <<"shift " <<  i <<" "<<  s(i) << endl;
+    return chi2;
+}
+
+void asFitter::printHighest(const TVectorD &s, int n) {
+    //TString sh;
+    map<double, int> shifts;
+    for(int i = 0; i < s.GetNrows(); ++i)
+        shifts[-abs(s(i))] = i;
+    int i = 0;
+    for(auto el : shifts) {
+        if(i < n) {
+            if(el.second < ErrNames.size())
+                cout << ErrNames[el.second] <<" : "<< s(el.second) << ", ";
+            else
+                cout << el.second <<" : "<< s(el.second) << ", ";
+        }
+        ++i;
+    }
+    cout << endl;
+}
+
+double asFitter::getChi2All()
+{
+    TVectorD s = getShiftsAll();
+    //s.Print();
+    //printHighest(s, 4);
+    //s.Reset();
+    //for(int i = 0; i < ErrNames.size(); ++i) s[i] = 0;
+
+    double chi2 = getChi2All(s);
+    
+    //print shifts
+    //for(int i = 0; i < data[0].errs.size(); ++i)
+        //cout <<"shift " <<  i <<" "<<  s(i) << endl;
+    return chi2;
+}
+
+TVectorD asFitter::getShifts()
+{
+    int nErr = data[0].errs.size();
+    TMatrixD mat(nErr, nErr);
+    TVectorD yVec(nErr);
+    //Calculate the optimal shifts
+    for(const auto &p : data) {
+        if(!Cut(p)) continue;
+
+        double ref = p.sigma;
+        double th  = p.th;
+        double C = pow(p.sigma*p.errStat,2) + pow(p.sigma*p.errUnc,2);
+        for(int j = 0; j < p.errs.size(); ++j)
+            for(int k = 0; k < p.errs.size(); ++k)
+                mat(j,k) += 1./C * ref*ref * p.errs[j]*p.errs[k];
+
+        for(int j = 0; j < p.errs.size(); ++j)
+            yVec(j) += - 1./C * (p.sigma - th) * ref * p.errs[j];
+
+    }
+
+    for(int j = 0; j < data[0].errs.size(); ++j)
+        mat(j,j) += 1;
+
+    //Solve 
+    TDecompSVD svd(mat);
+    Bool_t ok;
+    const TVectorD sh = svd.Solve(yVec, ok);
+
+    return sh;
+}
+
+TVectorD asFitter::getShiftsAll()
+{
+    INSTR_SCOPE("solveLegacy");
+    int nErr = data[0].errs.size() + data[0].thErrs.size();
+    TMatrixD mat(nErr, nErr);
+    TVectorD yVec(nErr);
+    //Calculate the optimal shifts
+    for(const auto &p : data) {
+        if(!Cut(p)) continue;
+
+        double th  = p.th;
+        double ref = p.sigma;
+        double C = pow(p.sigma*p.errStat,2) + pow(p.sigma*p.errUnc,2);
+        for(int j = 0; j < nErr; ++j)
+        for(int k = 0; k < nErr; ++k) {
+            double thJ = (j < p.errs.size()) ? p.errs[j] : p.thErrs[j-p.errs.size()];
+            double thK = (k < p.errs.size()) ? p.errs[k] : p.thErrs[k-p.errs.size()];
+            mat(j,k) += 1./C * ref*ref * thJ*thK;
+        }
+
+        for(int j = 0; j < nErr; ++j) {
+            double thJ = (j < p.errs.size()) ? p.errs[j] : p.thErrs[j-p.errs.size()];
+            yVec(j) += - 1./C * (p.sigma - th) * ref * thJ;
+        }
+
+    }
+
+    for(int j = 0; j < nErr; ++j)
+        mat(j,j) += 1;
+
+    //Solve 
+    TDecompSVD svd(mat);
+    Bool_t ok;
+    const TVectorD sh = svd.Solve(yVec, ok);
+
+    return sh;
+}
+
+TVectorD asFitter::getShiftsHERAall()
+{
+    INSTR_SCOPE("solveLegacy");
+    int nErr = data[0].errs.size() + data[0].thErrs.size();
+    TMatrixD mat(nErr, nErr);
+    TVectorD yVec(nErr);
+    //Calculate the optimal shifts
+    for(const auto &p : data) {
+        if(!Cut(p)) continue;
+
+        double m  = p.th;
+        double mu = p.sigma;
+        double C =  m*mu*pow(p.errStat,2) + m*m*pow(p.errUnc,2);
+        for(int j = 0; j < nErr; ++j)
+        for(int k = 0; k < nErr; ++k) {
+            double thJ = (j < p.errs.size()) ? p.errs[j] : p.thErrs[j-p.errs.size()];
+            double thK = (k < p.errs.size()) ? p.errs[k] : p.thErrs[k-p.errs.size()];
+            mat(j,k) += 1./C * m*m * thJ*thK;
+        }
+
+        for(int j = 0; j < nErr; ++j) {
+            double thJ = (j < p.errs.size()) ? p.errs[j] : p.thErrs[j-p.errs.size()];
+            yVec(j) += - 1./C * (p.sigma - m) * m * thJ;
+        }
+
+    }
+
+    for(int j = 0; j < nErr; ++j)
+        mat(j,j) += 1;
+
+    //Solve 
+    TDecompSVD svd(mat);
+    Bool_t ok;
+    const TVectorD sh = svd.Solve(yVec, ok);
+
+    return sh;
+}
+
+TVectorD asFitter::getShiftsHERAall(const vector<int> &iShifts, const vector<double> &shVals)
+{
+    INSTR_SCOPE("solveLegacy");
+    if(iShifts.size() != shVals.size()) {
+        fail(Form("%d fixed shifts with %d values", int(iShifts.size()), int(shVals.size())));
+    }
+    int nErr = data[0].errs.size() + data[0].thErrs.size();
+    initWork(nErr);
+    ws.matF.Zero();
+    ws.yVecF.Zero();
+    //Normal equations of all shifts (without the unit prior in matF)
+    for(const auto &p : data) {
+        if(!Cut(p)) continue;
+
+        double m  = p.th;
+        double mu = p.sigma;
+        double C =  m*mu*pow(p.errStat,2) + m*m*pow(p.errUnc,2);
+        for(int j = 0; j < nErr; ++j) {
+            double thJ = (j < p.errs.size()) ? p.errs[j] : p.thErrs[j-p.errs.size()];
+            for(int k = j; k < nErr; ++k) {
+                double thK = (k < p.errs.size()) ? p.errs[k] : p.thErrs[k-p.errs.size()];
+                ws.matF(j,k) += 1./C * m*m * thJ*thK;
+            }
+            ws.yVecF(j) += - 1./C * (mu - m) * m * thJ;
+        }
+    }
+    for(int j = 0; j < nErr; ++j)
+        for(int k = 0; k < j; ++k)
+            ws.matF(j,k) = ws.matF(k,j);
+
+    //The fixed shifts are moved to the right-hand side and decoupled (unit row and column),
+    //so that the solution contains their values
+    ws.mat = ws.matF;
+    for(int j = 0; j < nErr; ++j)
+        ws.mat(j,j) += 1;
+    TVectorD sh = ws.yVecF;
+    for(int i = 0; i < iShifts.size(); ++i)
+        for(int k = 0; k < nErr; ++k)
+            sh(k) -= ws.matF(k, iShifts[i]) * shVals[i];
+    for(int i = 0; i < iShifts.size(); ++i) {
+        int iS = iShifts[i];
+        for(int k = 0; k < nErr; ++k)
+            ws.mat(iS,k) = ws.mat(k,iS) = 0;
+        ws.mat(iS,iS) = 1;
+        sh(iS) = shVals[i];
+    }
+
+    //Solve
+    double *A = ws.mat.GetMatrixArray();
+    if(!cholDecompose(A, nErr)) {
+        fail("Normal matrix not positive definite");
+    }
+    cholForward(A, sh.GetMatrixArray(), nErr);
+    cholBackward(A, sh.GetMatrixArray(), nErr);
+    return sh;
+}
+
+void asFitter::fillPointsSoA(const vector<int> &idx, int nErr, pointsSoA &soa)
+{
+    soa.n = idx.size();
+    soa.nErr = nErr;
+    soa.nY = 0;
+    soa.yBin.resize(soa.n);
+    soa.eSum2.assign(soa.n, 0.);
+    soa.E.resize(size_t(nErr)*soa.n);
+    for(int i = 0; i < soa.n; ++i) {
+        const auto &p = data[idx[i]];
+        soa.yBin[i] = round(abs(2*p.yMin));
+        soa.nY = max(soa.nY, soa.yBin[i]+1);
+        for(int j = 0; j < nErr; ++j) {
+            double thJ = (j < p.errs.size()) ? p.errs[j] : p.thErrs[j-p.errs.size()];
+            soa.E[size_t(j)*soa.n + i] = thJ;
+            soa.eSum2[i] += thJ*thJ;
+        }
+    }
+    updatePointsSoA(idx, soa);
+}
+
+void asFitter::updatePointsSoA(const vector<int> &idx, pointsSoA &soa)
+{
+    soa.mu.resize(soa.n);
+    soa.m.resize(soa.n);
+    soa.stat2.resize(soa.n);
+    soa.unc2.resize(soa.n);
+    for(int i = 0; i < soa.n; ++i) {
+        const auto &p = data[idx[i]];
+        soa.mu[i]    = p.sigma;
+        soa.m[i]     = p.th;
+        soa.stat2[i] = p.errStat*p.errStat;
+        soa.unc2[i]  = p.errUnc*p.errUnc;
+    }
+}
+
+void asFitter::getChi2Fused(const pointsSoA &pt, const TVectorD *sH, const TVectorD *sNP, const TVectorD *sPDF, const TVectorD *sS, bool naive, chi2Fused &res)
+{
+    INSTR_SCOPE("chi2");
+    const int B = 8;
+    const TVectorD *sh[4] = {sH, sNP, sPDF, sS};
+    res.naive = 0;
+    res.heraLinY.assign(pt.nY, 0.);
+    res.heraLogY.assign(pt.nY, 0.);
+
+    double sum[4] = {0, 0, 0, 0};
+    for(int i0 = 0; i0 < pt.n; i0 += B) {
+        int nb = min(B, pt.n - i0);
+        alignas(64) double cor[4][B] = {};
+        for(int v = 0; v < 4; ++v) {
+            if(!sh[v]) continue;
+            const double *s = sh[v]->GetMatrixArray();
+            for(int j = 0; j < pt.nErr; ++j) {
+                const double *e = &pt.E[size_t(j)*pt.n + i0];
+                double sj = s[j];
+                #pragma omp simd
+                for(int l = 0; l < nb; ++l)
+                    cor[v][l] += sj * e[l];
+            }
+        }
+
+        for(int l = 0; l < nb; ++l) {
+            int i = i0 + l;
+            double m = pt.m[i], mu = pt.mu[i];
+            double CH = m*mu*pt.stat2[i] + m*m*pt.unc2[i];
+            double logH = log(CH / ((pt.stat2[i]+pt.unc2[i])*mu*mu));
+            for(int v = 0; v < 3; ++v) {
+                if(!sh[v]) continue;
+                double lin = pow(m - cor[v][l]*m - mu, 2) / CH;
+                sum[v] += lin + logH;
+                if(v == 0) {
+                    res.heraLinY[pt.yBin[i]] += lin;
+                    res.heraLogY[pt.yBin[i]] += logH;
+                }
+            }
+            if(sS) {
+                double CS = mu*mu*(pt.stat2[i] + pt.unc2[i]);
+                sum[3] += pow(mu - m + cor[3][l]*mu, 2) / CS;
+            }
+            if(naive)
+                res.naive += pow(m - mu, 2) / (mu*mu*(pt.eSum2[i] + pt.stat2[i] + pt.unc2[i]));
+        }
+    }
+
+    //penalty terms
+    for(int v = 0; v < 4; ++v)
+        if(sh[v])
+            for(int j = 0; j < pt.nErr; ++j)
+                sum[v] += pow((*sh[v])(j), 2);
+
+    res.hera = sum[0]; res.heraNoNP = sum[1]; res.heraNoPDF = sum[2]; res.simple = sum[3];
+}
+
+asFitter::chi2Fused asFitter::getChi2Fused(const pointsSoA &pt, const TVectorD *sH, const TVectorD *sNP, const TVectorD *sPDF, const TVectorD *sS, bool naive)
+{
+    chi2Fused res;
+    getChi2Fused(pt, sH, sNP, sPDF, sS, naive, res);
+    return res;
+}
+
+asFitter::nuisProducts asFitter::getNuisProducts(bool withEE)
+{
+    INSTR_SCOPE("nuisProducts");
+    nuisProducts np;
+    np.nErr = data[0].errs.size() + data[0].thErrs.size();
+    for(int i = 0; i < data.size(); ++i) {
+        const auto &p = data[i];
+        if(!Cut(p)) continue;
+        if(!withEE) {
+            np.idx.push_back(i);
+            continue;
+        }
+
+        vector<double> ee;
+        ee.reserve(np.nErr*(np.nErr+1)/2);
+        for(int j = 0; j < np.nErr; ++j) {
+            double thJ = (j < p.errs.size()) ? p.errs[j] : p.thErrs[j-p.errs.size()];
+            for(int k = j; k < np.nErr; ++k) {
+                double thK = (k < p.errs.size()) ? p.errs[k] : p.thErrs[k-p.errs.size()];
+                ee.push_back(thJ*thK);
+            }
+        }
+        np.idx.push_back(i);
+        np.EE.push_back(ee);
+    }
+    fillPointsSoA(np.idx, np.nErr, np.soa);
+    return np;
+}
+
+void asFitter::getWeights(const nuisProducts &np, TString type, vector<double> &w, vector<double> &d)
+{
+    w.resize(np.idx.size());
+    d.resize(np.idx.size());
+    for(int i = 0; i < np.idx.size(); ++i) {
+        const auto &p = data[np.idx[i]];
+        if(type == "S") {
+            w[i] = 1. / (pow(p.errStat,2) + pow(p.errUnc,2));
+            d[i] = (p.sigma - p.th) / p.sigma;
+        }
+        else {
+            double m  = p.th;
+            double mu = p.sigma;
+            double C =  m*mu*pow(p.errStat,2) + m*m*pow(p.errUnc,2);
+            w[i] = m*m / C;
+            d[i] = (mu - m) / m;
+        }
+    }
+}
+
+void asFitter::getNormalProducts(const nuisProducts &np, const vector<double> &w, const vector<double> &d, TMatrixD &mat, TVectorD &yVec)
+{
+    INSTR_SCOPE("normalMatrix");
+    int nErr = np.nErr;
+    for(int i = 0; i < np.idx.size(); ++i) {
+        const auto &p  = data[np.idx[i]];
+        const double *ee = np.EE[i].data();
+        for(int j = 0; j < nErr; ++j) {
+            for(int k = j; k < nErr; ++k)
+                mat(j,k) += w[i] * *ee++;
+            double thJ = (j < p.errs.size()) ? p.errs[j] : p.thErrs[j-p.errs.size()];
+            yVec(j) += - w[i] * d[i] * thJ;
+        }
+    }
+    for(int j = 0; j < nErr; ++j) {
+        for(int k = 0; k < j; ++k)
+            mat(j,k) = mat(k,j);
+        mat(j,j) += 1;
+    }
+}
+
+bool asFitter::cholDecompose(double *A, int n)
+{
+    for(int j = 0; j < n; ++j) {
+        double *Lj = &A[size_t(j)*n];
+        for(int k = 0; k < j; ++k)
+            Lj[j] -= Lj[k]*Lj[k];
+        if(Lj[j] <= 0) return false;
+        Lj[j] = sqrt(Lj[j]);
+        for(int i = j+1; i < n; ++i) {
+            double *Li = &A[size_t(i)*n];
+            for(int k = 0; k < j; ++k)
+                Li[j] -= Li[k]*Lj[k];
+            Li[j] /= Lj[j];
+        }
+    }
+    return true;
+}
+
+void asFitter::cholForward(const double *L, double *b, int n)
+{
+    for(int i = 0; i < n; ++i) {
+        const double *Li = &L[size_t(i)*n];
+        for(int k = 0; k < i; ++k)
+            b[i] -= Li[k]*b[k];
+        b[i] /= Li[i];
+    }
+}
+
+void asFitter::cholBackward(const double *L, double *b, int n)
+{
+    for(int i = n-1; i >= 0; --i) {
+        for(int k = i+1; k < n; ++k)
+            b[i] -= L[size_t(k)*n+i]*b[k];
+        b[i] /= L[size_t(i)*n+i];
+    }
+}
+
+void asFitter::getShiftsProducts(const nuisProducts &np, const vector<double> &w, const vector<double> &d, const vector<int> &iFixed, TVectorD &sh)
+{
+    int nErr = np.nErr;
+    initWork(nErr);
+    ws.matF.Zero();
+    ws.yVecF.Zero();
+    getNormalProducts(np, w, d, ws.matF, ws.yVecF);
+
+    ws.mat = ws.matF;
+    sh = ws.yVecF;
+    for(int i : iFixed) {
+        for(int k = 0; k < nErr; ++k)
+            ws.mat(i,k) = ws.mat(k,i) = 0;
+        ws.mat(i,i) = 1;
+        sh(i) = 0;
+    }
+
+    //Solve 
+    INSTR_SCOPE("solve");
+    double *A = ws.mat.GetMatrixArray();
+    if(!cholDecompose(A, nErr)) {
+        fail("Normal matrix not positive definite");
+    }
+    cholForward(A, sh.GetMatrixArray(), nErr);
+    cholBackward(A, sh.GetMatrixArray(), nErr);
+}
+
+TVectorD asFitter::getShiftsProducts(const nuisProducts &np, const vector<double> &w, const vector<double> &d, const vector<int> &iFixed)
+{
+    TVectorD sh(np.nErr);
+    getShiftsProducts(np, w, d, iFixed, sh);
+    return sh;
+}
+
+void asFitter::getShiftsBlock(const nuisProducts &np, const vector<double> &w, const vector<double> &d, const vector<int> &iFixed, TVectorD &sh)
+{
+    INSTR_SCOPE("solveBlock");
+    int nErr = data[0].errs.size() + data[0].thErrs.size();
+    initWork(nErr);
+    auto &bw = ws.blk;
+    const vector<int> &shared = bw.shared;
+    int nS = shared.size();
+
+    //the blocks are row-major, B_k is kept transposed (Bt_k[b][a]) so that its columns are contiguous
+    fill(bw.C.begin(), bw.C.end(), 0.);
+    fill(bw.yS.begin(), bw.yS.end(), 0.);
+    for(int k = 0; k < sets.size(); ++k) {
+        fill(bw.A[k].begin(),  bw.A[k].end(),  0.);
+        fill(bw.Bt[k].begin(), bw.Bt[k].end(), 0.);
+        fill(bw.z[k].begin(),  bw.z[k].end(),  0.);
+    }
+
+    auto errVal = [](const point &p, int j) { return (j < p.errs.size()) ? p.errs[j] : p.thErrs[j-p.errs.size()]; };
+
+    vector<double> &eK = bw.eK, &eS = bw.eS;
+    int k = 0;
+    for(int i = 0; i < np.idx.size(); ++i) {
+        const auto &p = data[np.idx[i]];
+        while(np.idx[i] >= sets[k].last) ++k; //the points are ordered by dataset
+        const auto &sk = bw.spec[k];
+        int nK = sk.size();
+        for(int a = 0; a < nK; ++a) eK[a] = errVal(p, sk[a]);
+        for(int b = 0; b < nS; ++b) eS[b] = errVal(p, shared[b]);
+
+        double *A = bw.A[k].data(), *Bt = bw.Bt[k].data(), *yK = bw.z[k].data();
+        for(int a = 0; a < nK; ++a) {
+            for(int a2 = a; a2 < nK; ++a2)
+                A[a*nK + a2] += w[i] * eK[a] * eK[a2];
+            yK[a] += - w[i] * d[i] * eK[a];
+        }
+        for(int b = 0; b < nS; ++b) {
+            for(int a = 0; a < nK; ++a)
+                Bt[b*nK + a] += w[i] * eK[a] * eS[b];
+            for(int b2 = b; b2 < nS; ++b2)
+                bw.C[b*nS + b2] += w[i] * eS[b] * eS[b2];
+            bw.yS[b] += - w[i] * d[i] * eS[b];
+        }
+    }
+
+    //symmetrize and add the unit prior
+    auto symUnit = [](vector<double> &m, int n) {
+        for(int j = 0; j < n; ++j) {
+            for(int l = 0; l < j; ++l)
+                m[j*n + l] = m[l*n + j];
+            m[j*n + j] += 1;
+        }
+    };
+    for(int kk = 0; kk < sets.size(); ++kk) symUnit(bw.A[kk], bw.spec[kk].size());
+    symUnit(bw.C, nS);
+
+    //fixed shifts: unit row and column, zero right-hand side
+    for(int j : iFixed) {
+        int kk = bw.of[j], a = bw.pos[j];
+        if(kk >= 0) {
+            int nK = bw.spec[kk].size();
+            for(int l = 0; l < nK; ++l) bw.A[kk][a*nK + l] = bw.A[kk][l*nK + a] = 0;
+            bw.A[kk][a*nK + a] = 1;
+            for(int b = 0; b < nS; ++b) bw.Bt[kk][b*nK + a] = 0;
+            bw.z[kk][a] = 0;
+        }
+        else {
+            for(int l = 0; l < nS; ++l) bw.C[a*nS + l] = bw.C[l*nS + a] = 0;
+            bw.C[a*nS + a] = 1;
+            for(int kB = 0; kB < sets.size(); ++kB) {
+                int nK = bw.spec[kB].size();
+                fill(bw.Bt[kB].begin() + a*nK, bw.Bt[kB].begin() + (a+1)*nK, 0.);
+            }
+            bw.yS[a] = 0;
+        }
+    }
+
+    //eliminate the dataset-specific blocks: X_k = A_k^-1 B_k, z_k = A_k^-1 y_k
+    //C -= B_k^T X_k, yS -= B_k^T z_k
+    for(int kk = 0; kk < sets.size(); ++kk) {
+        int nK = bw.spec[kk].size();
+        if(nK == 0) continue;
+        double *A = bw.A[kk].data(), *Bt = bw.Bt[kk].data(), *Xt = bw.Xt[kk].data(), *z = bw.z[kk].data();
+        if(!cholDecompose(A, nK)) {
+            fail("Normal matrix of dataset " + sets[kk].tag + " not positive definite");
+        }
+        copy(bw.Bt[kk].begin(), bw.Bt[kk].end(), bw.Xt[kk].begin());
+        for(int b = 0; b < nS; ++b) {
+            cholForward(A, Xt + b*nK, nK);
+            cholBackward(A, Xt + b*nK, nK);
+        }
+        cholForward(A, z, nK);
+        cholBackward(A, z, nK);
+
+        for(int b = 0; b < nS; ++b) {
+            const double *Bb = Bt + b*nK;
+            for(int b2 = 0; b2 < nS; ++b2) {
+                const double *Xb2 = Xt + b2*nK;
+                double sum = 0;
+                for(int a = 0; a < nK; ++a) sum += Bb[a] * Xb2[a];
+                bw.C[b*nS + b2] -= sum;
+            }
+            double sum = 0;
+            for(int a = 0; a < nK; ++a) sum += Bb[a] * z[a];
+            bw.yS[b] -= sum;
+        }
+    }
+
+    //shared block, the Schur complement is positive definite
+    if(!cholDecompose(bw.C.data(), nS)) {
+        fail("Normal matrix of the shared sources not positive definite");
+    }
+    cholForward(bw.C.data(), bw.yS.data(), nS);
+    cholBackward(bw.C.data(), bw.yS.data(), nS);
+
+    sh.ResizeTo(nErr);
+    for(int b = 0; b < nS; ++b)
+        sh(shared[b]) = bw.yS[b];
+    for(int kk = 0; kk < sets.size(); ++kk) {
+        int nK = bw.spec[kk].size();
+        const double *Xt = bw.Xt[kk].data(), *z = bw.z[kk].data();
+        for(int a = 0; a < nK; ++a) {
+            double xK = z[a];
+            for(int b = 0; b < nS; ++b)
+                xK -= Xt[b*nK + a] * bw.yS[b];
+            sh(bw.spec[kk][a]) = xK;
+        }
+    }
+}
+
+TVectorD asFitter::getShiftsBlock(const nuisProducts &np, const vector<double> &w, const vector<double> &d, const vector<int> &iFixed)
+{
+    TVectorD sh(data[0].errs.size() + data[0].thErrs.size());
+    getShiftsBlock(np, w, d, iFixed, sh);
+    return sh;
+}
+
+double asFitter::getChi2(const TVectorD &s)
+{
+    assert(data[0].errs.size() == s.GetNrows());
+
+    //Evaluate the chi2
+    double chi2 = 0;
+    for(const auto &p : data) {
+        if(!Cut(p)) continue;
+
+        double th = p.th;
+        double corErr = 0;
+        for(int i = 0; i < p.errs.size(); ++i)
+            corErr += s(i) * p.errs[i];
+
+        double C = pow(p.sigma*p.errStat,2) + pow(p.sigma*p.errUnc,2);
+        chi2 += pow(p.sigma - th + p.sigma*corErr, 2) / C;
+    }
+
+    for(int j = 0; j < data[0].errs.size(); ++j)
+        chi2 += pow(s(j),2);
+
+    return chi2;
+}
+
+double asFitter::getChi2All(const TVectorD &s)
+{
+    assert(data[0].errs.size() + data[0].thErrs.size() == s.GetNrows());
+
+    //Evaluate the chi2
+    double chi2 = 0;
+    for(const auto &p : data) {
+        if(!Cut(p)) continue;
+
+        double th  = p.th;
+        double ref = p.sigma;
+        double corErr = 0;
+        for(int i = 0; i < p.errs.size() + p.thErrs.size(); ++i) {
+            double thI = (i < p.errs.size()) ? p.errs[i] : p.thErrs[i-p.errs.size()];
+            corErr += s(i) * thI;
+        }
+
+        double C = pow(p.sigma*p.errStat,2) + pow(p.sigma*p.errUnc,2);
+        chi2 += pow(p.sigma - th  + corErr*ref, 2) / C;
+    }
+
+    for(int j = 0; j < data[0].errs.size() + data[0].thErrs.size(); ++j)
+        chi2 += pow(s(j),2);
+
+    return chi2;
+}
+
+double asFitter::getChi2HERAall(const TVectorD &s)
+{
+    assert(data[0].errs.size() + data[0].thErrs.size() == s.GetNrows());
+
+    //Evaluate the chi2
+    double chi2 = 0;
+    for(const auto &p : data) {
+        if(!Cut(p)) continue;
+
+        double m   = p.th;
+        double mu  = p.sigma;
+        //double th  = p.th;
+        //double ref = p.sigma;
+        double corErr = 0;
+        for(int i = 0; i < p.errs.size() + p.thErrs.size(); ++i) {
+            double thI = (i < p.errs.size()) ? p.errs[i] : p.thErrs[i-p.errs.size()];
+            corErr += s(i) * thI;
+        }
+
+        double C = m*mu*pow(p.errStat,2) + m*m*pow(p.errUnc,2);
+        //chi2 += pow(mu - m  + corErr*m, 2) / C;
+        chi2 += pow(m   - corErr*m  - mu, 2) / C;
+
+        //Log penalty
+        chi2 += log(C / ((pow(p.errStat,2)+pow(p.errUnc,2))*mu*mu));
+    }
+
+    for(int j = 0; j < data[0].errs.size() + data[0].thErrs.size(); ++j)
+        chi2 += pow(s(j),2);
+
+    return chi2;
+}
+
+double asFitter::getChi2naive()
+{
+    //Evaluate the chi2
+    double chi2 = 0;
+    for(const auto &p : data) {
+        if(!Cut(p)) continue;
+
+        double m   = p.th;
+        double mu  = p.sigma;
+        double err2 = 0;
+        for(int i = 0; i < p.errs.size() + p.thErrs.size(); ++i) {
+            double thI = (i < p.errs.size()) ? p.errs[i] : p.thErrs[i-p.errs.size()];
+            err2 += pow(thI*mu,2);
+        }
+        err2 += pow(p.errStat*mu,2) + pow(p.errUnc*mu,2);
+
+        chi2 += pow(m  - mu, 2) / err2;
+    }
+    return chi2;
+}
+
+pair<double,double> asFitter::getChi2HERAallPartial(const TVectorD &s)
+{
+    assert(data[0].errs.size() + data[0].thErrs.size() == s.GetNrows());
+
+    //Evaluate the chi2
+    double chi2Lin = 0;
+    double chi2Log = 0;
+    for(const auto &p : data) {
+        if(!Cut(p)) continue;
+
+        double m   = p.th;
+        double mu  = p.sigma;
+        //double th  = p.th;
+        //double ref = p.sigma;
+        double corErr = 0;
+        for(int i = 0; i < p.errs.size() + p.thErrs.size(); ++i) {
+            double thI = (i < p.errs.size()) ? p.errs[i] : p.thErrs[i-p.errs.size()];
+            corErr += s(i) * thI;
+        }
+
+        double C = m*mu*pow(p.errStat,2) + m*m*pow(p.errUnc,2);
+        //chi2 += pow(mu - m  + corErr*m, 2) / C;
+        chi2Lin += pow(m   - corErr*m  - mu, 2) / C;
+
+        //Log penalty
+        chi2Log += log(C / ((pow(p.errStat,2)+pow(p.errUnc,2))*mu*mu));
+    }
+
+    //for(int j = 0; j < data[0].errs.size() + data[0].thErrs.size(); ++j)
+        //chi2 += pow(s(j),2);
+
+    return {chi2Lin, chi2Log};
+}
+
+double asFitter::getChi2cov(const vector<int> &indx)
+{
+    INSTR_SCOPE("chi2Cov");
+    //Filter data
+    auto &idx = ws.cIdx;
+    idx.clear();
+    for(int i = 0; i < data.size(); ++i)
+        if(Cut(data[i])) idx.push_back(i);
+    int n = idx.size();
+
+    double Ccorr = 1;
+
+    auto &Cov = ws.cov;
+    Cov.assign(size_t(n)*n, 0.);
+    for(int i = 0; i < n; ++i) {
+        const auto &pI = data[idx[i]];
+        Cov[size_t(i)*n+i] = pow(pI.sigma*pI.errStat,2) + pow(pI.sigma*pI.errUnc,2);
+        for(int j = 0; j <= i; ++j) {
+            const auto &pJ = data[idx[j]];
+            double c = 0;
+            for(int k : indx) //data sys
+                c += pI.errs[k]*pJ.errs[k];
+            for(int k = 0; k < pI.thErrs.size(); ++k) //pdf sys
+                c += pI.thErrs[k]*pJ.thErrs[k] * Ccorr;
+            Cov[size_t(i)*n+j] += c * pI.sigma * pJ.sigma;
+        }
+    }
+
+    //Fill data - th
+    auto &diff = ws.diff;
+    diff.resize(n);
+    for(int i = 0; i < n; ++i)
+        diff[i] = data[idx[i]].sigma - data[idx[i]].th;
+
+    //Cov = L L^T, chi2 = |L^-1 diff|^2
+    if(!cholDecompose(Cov.data(), n)) {
+        fail("Covariance matrix not positive definite");
+    }
+    cholForward(Cov.data(), diff.data(), n);
+    double chi2 = 0;
+    for(int i = 0; i < n; ++i)
+        chi2 += diff[i]*diff[i];
+
+    return chi2;
+}
+
+void asFitter::initWork(int nErr)
+{
+    int nBlk = sets.size() > 1 ? sets.size() : 0;
+    if(ws.nErr == nErr && ws.iPDF.size() == data[0].thErrs.size() && ws.blk.spec.size() == nBlk) return;
+    ws.nErr = nErr;
+    ws.matF.ResizeTo(nErr, nErr);
+    ws.mat.ResizeTo(nErr, nErr);
+    ws.yVecF.ResizeTo(nErr);
+    for(TVectorD *v : {&ws.sH, &ws.sNP, &ws.sPDF, &ws.sS})
+        v->ResizeTo(nErr);
+    ws.iNP.clear();
+    for(int s = 0; s < ErrNames.size(); ++s)
+        if(ErrNames[s].BeginsWith("NP")) ws.iNP.push_back(s);
+    ws.iPDF.clear();
+    for(int s = data[0].errs.size(); s < data[0].errs.size()+data[0].thErrs.size(); ++s)
+        ws.iPDF.push_back(s);
+
+    //blocks of the joint fit: dataset k of each nuisance (-1 for shared) and its position in the block
+    auto &bw = ws.blk;
+    bw.of.assign(nErr, -1);
+    bw.pos.assign(nErr, 0);
+    bw.spec.assign(nBlk, {});
+    bw.shared.clear();
+    if(nBlk == 0) return;
+    for(int j = 0; j < nErr; ++j) {
+        for(int k = 0; k < nBlk; ++k)
+            if(j < ErrNames.size() && ErrNames[j].EndsWith("@" + sets[k].tag))
+                bw.of[j] = k;
+        vector<int> &v = (bw.of[j] >= 0) ? bw.spec[bw.of[j]] : bw.shared;
+        bw.pos[j] = v.size();
+        v.push_back(j);
+    }
+    int nS = bw.shared.size(), nKmax = 0;
+    bw.A.resize(nBlk);
+    bw.Bt.resize(nBlk);
+    bw.Xt.resize(nBlk);
+    bw.z.resize(nBlk);
+    for(int k = 0; k < nBlk; ++k) {
+        int nK = bw.spec[k].size();
+        nKmax = max(nKmax, nK);
+        bw.A[k].resize(size_t(nK)*nK);
+        bw.Bt[k].resize(size_t(nS)*nK);
+        bw.Xt[k].resize(size_t(nS)*nK);
+        bw.z[k].resize(nK);
+    }
+    bw.C.resize(size_t(nS)*nS);
+    bw.yS.resize(nS);
+    bw.eK.resize(nKmax);
+    bw.eS.resize(nS);
+}
+
+void asFitter::solveShifts(const nuisProducts &np, const vector<double> &w, const vector<double> &d, const vector<int> &iFixed, TVectorD &sh)
+{
+    if(sets.size() > 1) getShiftsBlock(np, w, d, iFixed, sh);
+    else                getShiftsProducts(np, w, d, iFixed, sh);
+}
+
+asFitter::chi2Result asFitter::getChi2s(int types, nuisProducts &np, const vector<int> &covIndx)
+{
+    chi2Result res;
+    bool fresh = false;
+    if(types & (chi2Simple | chi2HERA | chi2HERAnoNP | chi2HERAnoPDF | chi2Naive))
+        if(np.nErr == 0) {
+            np = getNuisProducts(sets.size() <= 1);
+            fresh = true;
+        }
+
+    //shifts of the requested variants
+    static const vector<int> noFixed;
+    if(np.nErr > 0) initWork(np.nErr);
+    if(types & (chi2HERA | chi2HERAnoNP | chi2HERAnoPDF)) {
+        getWeights(np, "H", ws.w, ws.d);
+        if(types & chi2HERA)      solveShifts(np, ws.w, ws.d, noFixed, ws.sH);
+        if(types & chi2HERAnoNP)  solveShifts(np, ws.w, ws.d, ws.iNP,  ws.sNP);
+        if(types & chi2HERAnoPDF) solveShifts(np, ws.w, ws.d, ws.iPDF, ws.sPDF);
+    }
+    if(types & chi2Simple) {
+        getWeights(np, "S", ws.w, ws.d);
+        solveShifts(np, ws.w, ws.d, noFixed, ws.sS);
+    }
+
+    //all variants in one pass over the points
+    if(types & (chi2HERA | chi2HERAnoNP | chi2HERAnoPDF | chi2Simple | chi2Naive)) {
+        if(!fresh) updatePointsSoA(np.idx, np.soa); //theory and unCorr errors change within the scan
+        chi2Fused &f = ws.fused;
+        getChi2Fused(np.soa, (types & chi2HERA) ? &ws.sH : nullptr, (types & chi2HERAnoNP) ? &ws.sNP : nullptr,
+                     (types & chi2HERAnoPDF) ? &ws.sPDF : nullptr, (types & chi2Simple) ? &ws.sS : nullptr, types & chi2Naive, f);
+        res.hera = f.hera; res.heraNoNP = f.heraNoNP; res.heraNoPDF = f.heraNoPDF;
+        res.simple = f.simple; res.naive = f.naive;
+    }
+    if(types & chi2Cov)
+        res.cov = getChi2cov(covIndx);
+    return res;
+}
+
+asFitter::chi2Result asFitter::getChi2s(int types, const vector<int> &covIndx)
+{
+    nuisProducts np;
+    return getChi2s(types, np, covIndx);
+}
+
+/*
+//Fill theory
+vector<TH1D*> readHistos(fastNLOAlphas &fnlo)
+{
+    fnlo.SetScaleFactorsMuRMuF(1.0, 1.0);
+    fnlo.CalcCrossSection();
+    vector<double> xs = fnlo.GetCrossSection();
+    
+    map<double, vector<double>> bins, xSec;
+    for(int k = 0; k < xs.size(); ++k) {
+        //cout << "Helenka " << k <<" "<< fnlodiff.GetObsBinLoBound(k,0) << endl;
+        double etaDn = fnlo.GetObsBinLoBound(k,0);
+        double ptDn  = fnlo.GetObsBinLoBound(k,1);
+        double etaUp = fnlo.GetObsBinUpBound(k,0);
+        double ptUp  = fnlo.GetObsBinUpBound(k,1);
+
+        bins[etaDn].push_back(ptDn);
+        if(k == xs.size() - 1 || fnlo.GetObsBinLoBound(k,0) != fnlo.GetObsBinLoBound(k+1,0))
+            bins[etaDn].push_back(ptUp);
+
+        xSec[etaDn].push_back(xs[k]);
+        //cout << etaAvg <<" "<<ptAvg << " "<< xs[0][k] <<" "<< xs[1][k] <<" "<< xs[2][k] <<" "<< xs[2][k]<<  endl;
+    }
+    cout << "First part done" << endl;
+
+    vector<TH1D*> hists;
+    for(auto obj : bins) {
+        double etaDn = obj.first;
+        vector<double> binning = obj.second;
+
+        TH1D * h = new TH1D(rn(), Form("%g", etaDn), binning.size()-1, binning.data());
+
+        cout << etaDn << endl;
+
+        for(int i = 0; i < xSec.at(etaDn).size(); ++i) {
+            h->SetBinContent(i+1, xSec.at(etaDn)[i]);
+            h->SetBinError(i+1, 0);
+        }
+
+        hists.push_back(h);
+    }
+
+
+    //cout << "Second part done Start" << endl;
+    //for(int i = 0; i < hists.size(); ++i)
+    //    hists[i]->Print();
+    //cout << "Second part done End " << hists.size() <<  endl;
+
+
+    return hists;
+}
+*/
+
+double asFitter::calcChi2(TString pdfName, double as, int scale) {
+
+    return calcChi2(pdfName, as, scale, chi2Cov).cov;
+    //return getChi2();
+}
+
+asFitter::chi2Result asFitter::calcChi2(TString pdfName, double as, int scale, int types) {
+
+    fillTheory(pdfName, as, scale);
+
+    vector<int> indx;
+    for(int i = 0; i < data[0].errs.size(); ++i) {
+        if(i != -1) indx.push_back(i); //remove luminosity
+    }
+    chi2Result r = getChi2s(types, indx);
+    cout << "chi2";
+    if(types & chi2Simple) cout <<" S "<< r.simple;
+    if(types & chi2Cov)    cout <<" C "<< r.cov;
+    if(types & chi2HERA)   cout <<" H "<< r.hera;
+    cout << endl;
+    return r;
+}
+
+void asFitter::ScanChi2(TString pdfName, int scale) {
+
+    for(auto as: pdfAsVals.at(pdfName)) {
+        fillTheory(pdfName, as, scale);
+
+        for(int i = 0; i < data[0].errs.size(); ++i) {
+            vector<int> indx;
+            indx.push_back(i);
+            double chi2 =  getChi2cov(indx);
+            cout << as <<" "<< i <<" "<< chi2 << endl;
+        }
+    }
+    //return getChi2();
+}
+
+void asFitter::printChi2Table()
+{
+    vector<TString> pdfSets = {"CT14nnlo", "HERAPDF20_NNLO", "NNPDF31_nnlo", "ABMP16_5_nnlo"};
+
+    for(auto p : pdfSets)
+        cout << p << " & ";
+    cout << endl;
+
+    for(int y = 0; y < 4; ++y) { //over rapidities
+        cout << y*0.5 <<" & " << (y+1)*0.5 << " & ";
+        Cut = [y](const point &p) { return ( abs(y*0.5-p.yMin) < 0.1 &&  p.sigma != 0);};
+        int ndf = getNpoints();
+
+        cout << ndf << " & ";
+        for(auto pdfSet : pdfSets) {
+            double chi2now = calcChi2(pdfSet, 0.118);
+            //cout  <<chi2now << " / " << ndf << " " ;
+            cout  <<chi2now << " & ";
+        }
+        cout << "//" << endl;
+
+    }
+
+    
+    { //Total chi2 
+        cout << "Total &&";
+        Cut = [](const point &p) { return ( abs(p.yMin) < 1.6 &&  p.sigma != 0);};
+        int ndf = getNpoints();
+
+        cout << ndf << " & ";
+        for(auto pdfSet : pdfSets) {
+            double chi2now = calcChi2(pdfSet, 0.118);
+            cout  <<chi2now <<  " & " ;
+        }
+        cout << "//" <<  endl;
+
+    }
+
+
+    //double chi2now = asfit.calcChi2("CT14nnlo", 0.118);
+    //cout << as <<" : "<<chi2now << " / " << ndf << endl;
+}
+
+void asFitter::printAsY(int y)
+{
+    if(y < 0) Cut = [y](const point &p) { return ( abs(p.yMin) < 1.6 &&  p.sigma != 0);};
+    else      Cut = [y](const point &p) { return ( abs(y*0.5-p.yMin) < 0.1 &&  p.sigma != 0);};
+
+    int ndf = getNpoints();
+    for(double as = 0.113; as <= 0.122; as +=0.001) {
+        //double chi2now = calcChi2("HERAPDF20_NLO", as);
+        double chi2now = calcChi2("CT14nlo", as);
+        cout << y <<" "<< as <<" : "<<chi2now << " / " << ndf << endl;
+    }
+}
+
+void asFitter::printAsPt(int pt)
+{
+    const vector<double> ptBinsAs = {97, 174, 272, 395, 548, 737, 967, 1248, 1588, 2000, 2500, 3103};
+    double ptMin = ptBinsAs[pt];
+    double ptMax = ptBinsAs[pt+1];
+    Cut = [ptMin,ptMax](const point &p) { return (  abs(p.yMin) < 1.6 &&  p.sigma != 0   && p.ptMin >= ptMin -1 &&  p.ptMax <= ptMax +1     );};
+
+
+    int ndf = getNpoints();
+    for(double as = 0.113; as <= 0.122; as +=0.001) {
+        //double chi2now = calcChi2("HERAPDF20_NLO", as);
+        double chi2now = calcChi2("CT14nlo", as);
+        cout << ptBinsAs[pt] <<" "<< as <<" : "<<chi2now << " / " << ndf << endl;
+    }
+}
+
+TGraph *asFitter::getFitGraphPt(TString pdfName, int pt, int scale)
+{
+    double ptMin = ptBinsAs[pt];
+    double ptMax = ptBinsAs[pt+1];
+    Cut = [ptMin,ptMax](const point &p) { return (  abs(p.yMin) < 0.3 &&  p.sigma != 0   && p.ptMin >= ptMin -1 &&  p.ptMax <= ptMax +1     );};
+
+    int ndf = getNpoints();
+
+    TGraph *gr = new TGraph();
+
+    int i = 0;
+    for(double as  : pdfAsVals.at(pdfName) ) {
+        double chi2now = calcChi2(pdfName, as, scale);
+        //cout << y <<" "<< as <<", scale="<<scale <<" : "<<chi2now << " / " << ndf << endl;
+        gr->SetPoint(i, as, chi2now);
+        ++i;
+    }
+    addAsFit(gr);
+    return gr;
+}
+
+vector<TGraph*> asFitter::getFitGraphs(TString pdfName, int y, int scale)
+{
+    if(y < 0) Cut = [y](const point &p) { return ( abs(p.yMin) < 1.6 &&  p.sigma != 0 && p.ptMin > 95);};
+    else      Cut = [y](const point &p) { return ( abs(y*0.5-p.yMin) < 0.1 &&  p.sigma != 0 && p.ptMin > 95);};
+    //Cut = [y](const point &p) { return ( abs(p.yMin) < 1.6 &&  p.sigma != 0);};
+    int ndf = getNpoints();
+
+    TGraph *grAll = new TGraph();
+    TGraph *grNP  = new TGraph();
+    TGraph *grPDF = new TGraph();
+
+    int i = 0;
+    for(double as  : pdfAsVals.at(pdfName) ) {
+        //double chi2now = calcChi2(pdfName, as, scale);
+
+        //calculate the theory for PDF & as
+        fillTheory(pdfName, as, scale);
+
+        //double chi2N = getChi2All();
+
+        // TODO
+        auto shifts    = getShiftsHERAall();
+        double chi2All = getChi2HERAall(shifts);
+        auto shiftsNP  = getShiftsHERAall({0}, {0}); //without NP
+        double chi2NP  = getChi2HERAall(shiftsNP);
+
+
+        //data[0].errs.size();
+        vector<int> indx;
+        vector<double>  shPDF;
+        for(int s = data[0].errs.size(); s < data[0].errs.size()+data[0].thErrs.size(); ++s) {
+            indx.push_back(s);
+            shPDF.push_back(0);
+        }
+        auto shiftsPDF = getShiftsHERAall(indx, shPDF); //without NP
+        double chi2PDF = getChi2HERAall(shiftsPDF);//without PDF
+
+
+        cout << y <<" "<< as <<", scale="<<scale <<" : "<<chi2All << " / " << ndf << endl;
+        grAll->SetPoint(i, as, chi2All);
+        grNP->SetPoint(i, as, chi2NP);
+        grPDF->SetPoint(i, as, chi2PDF);
+        ++i;
+    }
+    addAsFit(grAll);
+    addAsFit(grNP);
+    addAsFit(grPDF);
+    return {grAll, grNP, grPDF};
+}
+
+void asFitter::setCut(int y, int ipt)
+{
+    double yM = yMaxCut, ptM = ptMinCut;
+    if(ipt == -1) {
+        if(y < 0) Cut = [y,yM,ptM](const point &p) { return ( abs(p.yMin) < yM &&  p.sigma != 0 && p.ptMin > ptM);};
+        else      Cut = [y,ptM](const point &p) { return ( abs(y*0.5-p.yMin) < 0.1 &&  p.sigma != 0 && p.ptMin > ptM);};
+    }
+    else {
+        if(y < 0) Cut = [y,ipt,yM](const point &p) { return ( abs(p.yMin) < yM &&  p.sigma != 0 && p.ptMin > ptBinsAs[ipt]-1  &&  p.ptMin < ptBinsAs[ipt]+1       );};
+        else      Cut = [y,ipt](const point &p) { return ( abs(y*0.5-p.yMin) < 0.1 &&  p.sigma != 0 && p.ptMin > ptBinsAs[ipt]-1  && p.ptMin < ptBinsAs[ipt]+1  );};
+    }
+}
+
+vector<vector<vector<TGraph*>>> asFitter::getFitGraphsAll(TString pdfName, int y, int ipt, int scale, const vector<double> &unCorrs)
+{
+    setCut(y, ipt);
+
+    //Cut = [y](const point &p) { return ( abs(p.yMin) < 1.6 &&  p.sigma != 0);};
+    int ndf = getNpoints();
+
+    vector<double> uncOrg;
+    for(const auto &p : data)
+        uncOrg.push_back(p.errUnc);
+
+    vector<vector<vector<TGraph*>>> grs(unCorrs.size());
+    for(auto &g : grs)
+        g = {{new TGraph(), new TGraph(), new TGraph()}, {new TGraph()}, {new TGraph()}};
+
+    //the pdf variations are taken at 0.118, i.e. the same for all alphaS
+    //so the nuisance products are calculated at the first alphaS only
+    nuisProducts np;
+    const int types = chi2HERA | chi2HERAnoNP | chi2HERAnoPDF | chi2Simple | chi2Naive;
+
+    int i = 0;
+    for(double as  : getAsScan(pdfName) ) {
+        //calculate the theory for PDF & as
+        fillTheory(pdfName, as, scale);
+
+        for(int u = 0; u < unCorrs.size(); ++u) {
+            setUnCorr(unCorrs[u]);
+
+            chi2Result r = getChi2s(types, np);
+
+            cout << y <<" "<< as <<", scale="<<scale <<", unc="<< unCorrs[u] <<" : "<<r.hera << " / " << ndf << endl;
+            grs[u][0][0]->SetPoint(i, as, r.hera);
+            grs[u][0][1]->SetPoint(i, as, r.heraNoNP);
+            grs[u][0][2]->SetPoint(i, as, r.heraNoPDF);
+
+            grs[u][1][0]->SetPoint(i, as, r.simple);
+            grs[u][2][0]->SetPoint(i, as, r.naive);
+        }
+
+        ++i;
+    }
+
+    for(int k = 0; k < data.size(); ++k)
+        data[k].errUnc = uncOrg[k];
+
+    return grs;
+}
+
+vector<TString> asFitter::getPdfNames() const
+{
+    vector<TString> pdfNames;
+    for(const auto &el :  thStores)
+        if(!el.first.Contains('@'))
+            pdfNames.push_back(el.first);
+    return pdfNames;
+}
+
+void asFitter::scanAllChi2s(vector<TString> orders, vector<double> unCorrs, TString fName)
+{
+    chi2ScanWriter out(fName);
+    for(auto o : orders)
+        scanAllChi2s(o, unCorrs, out);
+    INSTR_SCOPE("rootWrite");
+    out.close();
+}
+
+void asFitter::scanAllChi2s(TString orderNow, vector<double> unCorrs, chi2ScanWriter &out)
+{
+    order = orderNow;
+    vector<int> uncs;
+    for(auto &unCorr : unCorrs) {
+        if(unCorr < 0) unCorr = 0;
+        uncs.push_back(round(unCorr*10));
+    }
+
+    //retrieve loaded PDF names
+    vector<TString> pdfNames = getPdfNames();
+
+    vector<TFile*> fOuts;
+    if(writeGraphs)
+        for(int unc : uncs)
+            fOuts.push_back(TFile::Open(Form("chi2Anal/chi2new_%s_%d.root",order.Data(), unc), "RECREATE"));
+
+    for(auto pdfName : pdfNames) { //over pdf
+        for(int y = -1; y < 4; ++y) { //over y
+            cout << "Radek before "<< y<<" " <<__LINE__<< " "<<  ptBinsAs.size() <<endl;
+            const int ptMax = ptBinsAs.size()-1;
+            for(int ipt = -1; ipt < ptMax; ++ipt) { //over ipt
+                for(int s : scanScales) { //over s
+                    auto grsU = getFitGraphsAll(pdfName, y, ipt, s, unCorrs);
+                    int ndf = getNpoints();
+                    //TString bName = (y==-1) ? Form("_scale%d", s) : Form("_Y%d_scale%d", y, s);
+
+                    //cout << "Radek in " << y <<" "<< ipt <<" "<< s << endl;
+                    TString pdfN = pdfName;
+                    pdfN.ReplaceAll("_","");
+
+                    for(int u = 0; u < uncs.size(); ++u) {
+                        auto &grs = grsU[u];
+                        out.fill(pdfName, order, unCorrs[u], y, ipt, s, "Hall",   ndf, grs[0][0]);
+                        out.fill(pdfName, order, unCorrs[u], y, ipt, s, "HnoNP",  ndf, grs[0][1]);
+                        out.fill(pdfName, order, unCorrs[u], y, ipt, s, "HnoPDF", ndf, grs[0][2]);
+                        out.fill(pdfName, order, unCorrs[u], y, ipt, s, "Sall",   ndf, grs[1][0]);
+                        out.fill(pdfName, order, unCorrs[u], y, ipt, s, "Nall",   ndf, grs[2][0]);
+                        if(!writeGraphs) {
+                            for(auto &gv : grs) for(auto g : gv) delete g;
+                            continue;
+                        }
+
+                        fOuts[u]->cd();
+                        TString bName = pdfN +"_"+order+TString("_Unc")+uncs[u] + Form("_Y%d_pt%d_scl%d", y+1, ipt+1, s);
+
+                        grs[0][0]->Write(bName + "_Hall");
+                        grs[0][1]->Write(bName + "_HnoNP");
+                        grs[0][2]->Write(bName + "_HnoPDF");
+
+                        grs[1][0]->Write(bName + "_Sall");
+                        grs[2][0]->Write(bName + "_Nall");
+                    }
+
+                }
+            }
+        }
+    }
+    cout << "Radek before " <<__LINE__<< endl;
+    INSTR_SCOPE("rootWrite");
+    for(auto fOut : fOuts) {
+        fOut->Write();
+        fOut->Close();
+    }
+}
+
+void asFitter::getAllChi2s()
+{
+
+    vector<TString> pdfNames = getPdfNames();
+
+    TFile *fOut = TFile::Open("chi2.root", "RECREATE");
+    for(auto pdfName : pdfNames) {
+        for(int y = -1; y < 4; ++y) {
+            for(int s = 0; s < 7; ++s) {
+                auto grs = getFitGraphs(pdfName, y, s);
+                TString bName = (y==-1) ? Form("_scale%d", s) : Form("_Y%d_scale%d", y, s);
+                grs[0]->Write(pdfName + bName + "_all");
+                grs[1]->Write(pdfName + bName + "_noNP");
+                grs[2]->Write(pdfName + bName + "_noPDF");
+            }
+        }
+    }
+
+    /*
+    //Fill pT dep
+    for(auto pdfName : pdfNames) {
+        for(int pt = 0; pt < ptBinsAs.size()-1; ++pt) {
+            for(int s = 0; s < 7; ++s) {
+                TGraph *gr = getFitGraphPt(pdfName, pt, s);
+                gr->Write(pdfName + Form("_Pt%d_scale%d", pt, s));
+            }
+        }
+    }
+    */
+
+
+    fOut->Write();
+    fOut->Close();
+}
+
+asFitResult asFitter::getAsFit(TGraph *gr)
+{
+    return fitAsPol4(gr->GetX(), gr->GetY(), gr->GetN());
+}
+
+double asFitter::getAsMin(TGraph *gr)
+{
+    return getAsFit(gr).asMin;
+}
+
+void asFitter::addAsFit(TGraph *gr)
+{
+    gr->GetListOfFunctions()->Add(getAsFitFunction(getAsFit(gr)));
+}
+
+void asFitter::influenceAnalysis(TString pdfName, int scale)
+{
+    const vector<double> &asVals = pdfAsVals.at(pdfName);
+    int nAs = asVals.size();
+
+    nuisProducts np;
+    vector<double> w, d;
+    vector<double> chi2Full(nAs);
+    vector<vector<double>> chi2Rem;
+
+    for(int ia = 0; ia < nAs; ++ia) {
+        fillTheory(pdfName, asVals[ia], scale);
+        if(ia == 0) {
+            np = getNuisProducts();
+            chi2Rem.assign(np.idx.size(), vector<double>(nAs));
+        }
+        getWeights(np, "H", w, d);
+
+        int nErr = np.nErr;
+        TMatrixD mat(nErr, nErr);
+        TVectorD b(nErr);
+        getNormalProducts(np, w, d, mat, b);
+
+        TDecompChol chol(mat);
+        chol.Decompose();
+        TVectorD sh = b;
+        chol.Solve(sh);
+
+        //chi2 at the minimum without the shifts dependent part
+        double chi2Const = 0, bs = 0;
+        vector<double> logs(np.idx.size());
+        for(int i = 0; i < np.idx.size(); ++i) {
+            const auto &p = data[np.idx[i]];
+            double C = p.th*p.sigma*pow(p.errStat,2) + p.th*p.th*pow(p.errUnc,2);
+            logs[i] = log(C / ((pow(p.errStat,2)+pow(p.errUnc,2))*p.sigma*p.sigma));
+            chi2Const += w[i]*d[i]*d[i] + logs[i];
+        }
+        for(int j = 0; j < nErr; ++j)
+            bs += b(j)*sh(j);
+        chi2Full[ia] = chi2Const - bs;
+
+        //the same buffers for all the left-out points
+        TVectorD e(nErr), u(nErr);
+        for(int q = 0; q < np.idx.size(); ++q) {
+            const auto &p = data[np.idx[q]];
+            for(int j = 0; j < nErr; ++j)
+                e(j) = (j < p.errs.size()) ? p.errs[j] : p.thErrs[j-p.errs.size()];
+
+            u = e;
+            chol.Solve(u); //u = A^{-1} e
+            double h = 0, es = 0;
+            for(int j = 0; j < nErr; ++j) {
+                h  += e(j)*u(j);
+                es += e(j)*sh(j);
+            }
+            double f = w[q] * (d[q] + es) / (1 - w[q]*h);
+
+            double bsQ = 0;
+            for(int j = 0; j < nErr; ++j) {
+                double shQ = sh(j) + f*u(j);
+                double bQ  = b(j) + w[q]*d[q]*e(j);
+                bsQ += bQ*shQ;
+            }
+            chi2Rem[q][ia] = chi2Const - w[q]*d[q]*d[q] - logs[q] - bsQ;
+        }
+    }
+
+    //alphaS fits
+    TGraph *grFull = new TGraph(nAs, asVals.data(), chi2Full.data());
+    asFitResult fitFull = getAsFit(grFull);
+    double asFull = fitFull.asMin;
+    double chi2MinFull = fitFull.chi2Min;
+
+    cout << "Influence analysis " << pdfName << " scale " << scale << " order " << order << endl;
+    cout << "All points: alphaS = " << asFull << ", chi2 = " << chi2MinFull << " / " << np.idx.size() << endl;
+    cout << "id yMin ptMin ptMax chi2Min dChi2 alphaS dAlphaS" << endl;
+    for(int q = 0; q < np.idx.size(); ++q) {
+        const auto &p = data[np.idx[q]];
+        TGraph *gr = new TGraph(nAs, asVals.data(), chi2Rem[q].data());
+        asFitResult fitQ = getAsFit(gr);
+        double asQ = fitQ.asMin;
+        double chi2MinQ = fitQ.chi2Min;
+        cout << np.idx[q] <<" "<< p.yMin <<" "<< p.ptMin <<" "<< p.ptMax <<" "<< chi2MinQ <<" "<< chi2MinFull - chi2MinQ
+             <<" "<< asQ <<" "<< asQ - asFull << endl;
+        delete gr;
+    }
+    delete grFull;
+}
+
+double asFitter::fitAsHERA(TString pdfName, int scale)
+{
+    const vector<double> &asVals = pdfAsVals.at(pdfName);
+    vector<double> chi2s;
+    nuisProducts np;
+    vector<double> w, d;
+    for(int ia = 0; ia < asVals.size(); ++ia) {
+        fillTheory(pdfName, asVals[ia], scale);
+        if(ia == 0) np = getNuisProducts();
+        getWeights(np, "H", w, d);
+        chi2s.push_back(getChi2HERAall(getShiftsProducts(np, w, d)));
+    }
+    TGraph *gr = new TGraph(asVals.size(), asVals.data(), chi2s.data());
+    double asMin = getAsMin(gr);
+    delete gr;
+    return asMin;
+}
+
+vector<pair<double,int>> asFitter::rankSources(TString pdfName, int scale)
+{
+    fillTheory(pdfName, 0.118, scale);
+    nuisProducts np = getNuisProducts();
+    vector<double> w, d;
+    getWeights(np, "H", w, d);
+    double chi2All = getChi2HERAall(getShiftsProducts(np, w, d));
+
+    vector<pair<double,int>> rank;
+    for(int j = 0; j < ErrNames.size(); ++j) {
+        if(ErrNames[j].BeginsWith("NP")) continue; //theory nuisances (ws.iNP), as the pdf ones not ranked
+        double chi2Now = getChi2HERAall(getShiftsProducts(np, w, d, {j}));
+        rank.push_back({chi2Now - chi2All, j});
+    }
+    sort(rank.begin(), rank.end());
+    return rank;
+}
+
+void asFitter::pruneSources(TString pdfName, double threshold, bool merge, bool verify, int scale)
+{
+    double asBefore = verify ? fitAsHERA(pdfName, scale) : 0;
+
+    auto rank = rankSources(pdfName, scale);
+    vector<int> iRem;
+    cout << "Source ranking (dChi2):" << endl;
+    for(auto r : rank) {
+        cout << ErrNames[r.second] << " : " << r.first << endl;
+        if(r.first < threshold) iRem.push_back(r.second);
+    }
+
+    vector<TString> ErrNamesNew;
+    for(int j = 0; j < ErrNames.size(); ++j)
+        if(find(iRem.begin(), iRem.end(), j) == iRem.end())
+            ErrNamesNew.push_back(ErrNames[j]);
+
+    for(auto &p : data) {
+        vector<double> errsNow;
+        for(int j = 0; j < p.errs.size(); ++j) {
+            if(find(iRem.begin(), iRem.end(), j) == iRem.end())
+                errsNow.push_back(p.errs[j]);
+            else if(merge) {
+                p.errMerged = hypot(p.errMerged, p.errs[j]);
+                p.errUnc    = hypot(p.errUnc,    p.errs[j]);
+            }
+        }
+        p.errs = errsNow;
+    }
+    ErrNames = ErrNamesNew;
+    cout << "Pruned " << iRem.size() << " sources (threshold " << threshold << (merge ? ", merged" : ", dropped") << "), "
+         << ErrNames.size() << " remaining" << endl;
+
+    if(verify) {
+        double asAfter = fitAsHERA(pdfName, scale);
+        cout << "Pruning verification " << pdfName << " : alphaS " << asBefore << " -> " << asAfter
+             << ", shift " << asAfter - asBefore << endl;
+    }
+}
+
+void asFitter::fitAs(TString pdfName, int y)
+{
+    for(int s = 0; s < 7; ++s) {
+        TCanvas *c = new TCanvas(rn(), "can", 600, 600);
+        auto grs = getFitGraphs(pdfName, y, s);
+        auto gr  = grs[0];
+
+        asFitResult fit = getAsFit(gr);
+        cout << "Helenka min " << fit.asMin << " "<< fit.errDn <<" "<< fit.errUp << endl;
+        gr->Draw("a*");
+        c->SaveAs(Form("asFit%d.pdf", s));
+    }
+
+}
+
+void asFitter::TheoryPlotter()
+{	
+
+
+}
+
+void asFitter::plotReview(TString pdfName, double as, int scale)
+{
+    const int ptMin = 550;
+    //const int ptMin = 95;
+    const int nYbins = 4;
+    Cut = [ptMin](const point &p) { return ( abs(p.yMin) < 0.5*(nYbins-0.9) &&  p.sigma != 0 && p.ptMin > ptMin);};
+
+    gStyle->SetOptStat(0);
+    fillTheory(pdfName, as, scale);
+
+
+    int nSys = data[0].errs.size();
+    int nTh  = data[0].thErrs.size();
+
+    auto shifts  = getShiftsHERAall();
+    double chi2H = getChi2HERAall(shifts);
+
+    auto shiftsS  = getShiftsAll();
+    double chi2S = getChi2All(shiftsS);
+
+
+    double chi2Naive = getChi2naive();
+
+    //Uncertainties of the shifts
+    TVectorD shiftsUnc(shifts.GetNrows());
+    for(int i = 0; i < shifts.GetNrows(); ++i) {
+        auto shiftsU  = getShiftsHERAall({i}, {shifts(i)+1}); //up-variation
+        double dChi2 = getChi2HERAall(shiftsU) - chi2H;
+        shiftsUnc(i) = 1./sqrt(dChi2);
+    }
+    
+
+    /*
+    auto shiftsT   = getShiftsHERAall(0, shifts(0));
+    auto shiftsTU  = getShiftsHERAall(0, shifts(0)+1);
+    auto shiftsTD  = getShiftsHERAall(0, shifts(0)-1);
+    for(int i = 0; i < shifts.GetNrows(); ++i) {
+        cout << i <<" "<< shifts(i) <<" "<<shiftsT(i) << endl;
+    }
+    cout << "Chi2 comparison " << getChi2HERAall(shifts) <<" : "<< getChi2HERAall(shiftsT) << " "<< getChi2HERAall(shiftsTU)<<" "<< getChi2HERAall(shiftsTD) << endl;
+    exit(0);
+    */
+
+    int ndfT  = getNpoints();
+    assert(shifts.GetNrows() == nSys + nTh);
+
+
+    //Partial chi2 of the rapidity bins with the overall shifts, in one pass
+    nuisProducts npAll = getNuisProducts(false);
+    chi2Fused fAll = getChi2Fused(npAll.soa, &shifts, nullptr, nullptr, nullptr, false);
+
+    //Get chi2 for all rap bins
+    vector<double> chi2NY(nYbins), chi2TotY(nYbins),  chi2STotY(nYbins),   chi2LY(nYbins);
+    vector<int> ndfY(nYbins);
+    for(int y = 0; y < nYbins; ++y) {
+        Cut = [y,ptMin](const point &p) { return ( round(abs(2*p.yMin)) == y &&  p.sigma != 0 && p.ptMin > ptMin);};
+        if(y < fAll.heraLinY.size()) {
+            chi2NY[y] = fAll.heraLinY[y]; //partial chi2
+            chi2LY[y] = fAll.heraLogY[y];
+        }
+
+        auto shiftsNow  = getShiftsHERAall();
+        chi2TotY[y] = getChi2HERAall(shiftsNow); //overall chi2 for bin y
+
+        auto shiftsSNow  = getShiftsAll();
+        chi2STotY[y] = getChi2All(shiftsSNow); //overall chi2 for bin y
+
+        ndfY[y]  = getNpoints();
+    }
+
+
+    //Shifts to histogram
+    TH1D *hShifts = new TH1D(rn(), "", shifts.GetNrows(), 0.5, shifts.GetNrows()+0.5);
+    for(int i = 0; i < shifts.GetNrows(); ++i) {
+        hShifts->SetBinContent(i+1, shifts[i]);
+        hShifts->SetBinError(i+1, shiftsUnc[i]);
+        if(i < nSys) hShifts->GetXaxis()->SetBinLabel(i+1, ErrNames[i]);
+    }
+
+
+    //Get binning of the data
+    vector<vector<double>> bins(nYbins);
+    for(auto p : data) {
+        int y = round(p.yMin*2);
+        if(y >= nYbins || p.ptMin < ptMin) continue;
+        bins[y].push_back(p.ptMin);
+        bins[y].push_back(p.ptMax);
+    }
+    for(auto &bin : bins) {
+        sort(bin.begin(), bin.end());
+        auto it = unique(bin.begin(), bin.end());
+        bin.resize(distance(bin.begin(), it));
+    }
+
+    //Init all histograms
+    vector<TH1D*> hData(nYbins);
+    vector<TH1D*> hTh(nYbins);
+    vector<TH1D*> hThShTot(nYbins);
+    vector<vector<TH1D*>> hShData(nSys);
+    vector<vector<TH1D*>> hShTh(nTh);
+
+    for(int y = 0; y < nYbins; ++y) {
+       hData[y] = new TH1D(rn(), "", bins[y].size()-1, bins[y].data()); 
+       hTh[y]   = new TH1D(rn(), "", bins[y].size()-1, bins[y].data()); 
+       hThShTot[y] = new TH1D(rn(), "", bins[y].size()-1, bins[y].data()); 
+       for(int s = 0; s < nSys; ++s) {
+           hShData[s].resize(nYbins);
+           hShData[s][y] = new TH1D(rn(), "", bins[y].size()-1, bins[y].data()); 
+       }
+
+       for(int s = 0; s < nTh; ++s) {
+           hShTh[s].resize(nYbins);
+           hShTh[s][y] = new TH1D(rn(), "", bins[y].size()-1, bins[y].data()); 
+       }
+    }
+
+
+    //Fill theory and data
+    for(auto p : data) {
+        int y = round(p.yMin*2);
+        if(y >= nYbins) continue;
+        int ipt = hData[y]->FindBin((p.ptMin+p.ptMax)/2);
+        hData[y]->SetBinContent(ipt, p.sigma);
+        hData[y]->SetBinError(ipt, hypot(p.errStat,p.errUnc)*p.sigma);
+        hTh[y]->SetBinContent(ipt, p.th);
+        hTh[y]->SetBinError(ipt, 0);
+
+
+        //Fill shifted theory
+        double shTot = 0;
+        for(int s = 0; s < p.errs.size(); ++s) {
+            shTot += p.errs[s]*shifts[s]*p.th;
+            hShData[s][y]->SetBinContent(ipt, -p.errs[s]*shifts[s]);
+            hShData[s][y]->SetBinError(ipt, 0);
+        }
+            
+        for(int s = 0; s < p.thErrs.size(); ++s) {
+            shTot += p.thErrs[s]*shifts[p.errs.size()+s]*p.th;
+            hShTh[s][y]->SetBinContent(ipt, -p.thErrs[s]*shifts[p.errs.size()+s]);
+            hShTh[s][y]->SetBinError(ipt, 0);
+        }
+        hThShTot[y]->SetBinContent(ipt, p.th-shTot);
+        hThShTot[y]->SetBinError(ipt, 0);
+
+    }
+    
+
+    //Get important data shifts
+    map<double,int> shImportance;
+    for(int s = 0; s < nSys; ++s) {
+        double M = -1e10;
+        for(int y = 0; y < nYbins; ++y) {
+            M = max(M, abs(hShData[s][y]->GetBinContent(2)));
+            M = max(M, abs(hShData[s][y]->GetBinContent(5)));
+            M = max(M, abs(hShData[s][y]->GetBinContent(10)));
+        }
+        shImportance[M] = s;
+    }
+    auto it = shImportance.begin();
+    cout << "Radek start " << shImportance.size() <<" "<< nSys <<endl;
+    std::advance(it, shImportance.size()-5);
+    shImportance.erase(shImportance.begin(), it);
+    cout << "Radek after " << shImportance.size() << endl;
+    map<int,int> shImp;
+    vector<int> myCols = {kBlue, kGreen+2, kYellow+2, kViolet, kCyan+2,
+                     kPink+6, kOrange+3, kAzure-4, kGray+3, kGreen-6};
+    int ic = 0;
+    for(auto s : shImportance) {
+        //cout << "Radek insering " << s.second << endl;
+        shImp[s.second] = myCols[ic++];
+    }
+
+
+    TCanvas *can = new TCanvas(rn(), "", 1000, 700);
+    SetTopBottom(0.05, 0.15);
+    DividePad({1}, {1,1,1,1,1});
+    //DivideTransparent({1}, {1,0,1,0,1,0,1,0.2,1});
+
+    //Ratio to theory
+    can->cd(1);
+    DividePad(vector<double>(nYbins,1.), {1});
+    for(int y = 0; y < nYbins; ++y) {
+        can->cd(1)->cd(y+1);
+        gPad->SetLogx();
+        auto hDataR = (TH1D*) hData[y]->Clone(rn());
+        auto hThShR = (TH1D*) hThShTot[y]->Clone(rn());
+        auto hThR   = (TH1D*) hTh[y]->Clone(rn());
+
+        //int ipt = hDataR->FindBin(240);
+        //cout << "Data: " << hDataR->GetBinContent(ipt) << endl;
+        //cout << "NNLO: " << hThR->GetBinContent(ipt) << endl;
+        //exit(0);
+
+        hDataR->Divide(hTh[y]);
+        hThShR->Divide(hTh[y]);
+        hThR->Divide(hTh[y]);
+
+        hDataR->SetLineColor(kBlack);
+        hThShR->SetLineColor(kBlue);
+        hThR->SetLineColor(kRed);
+
+        hThR->Draw();
+        hThShR->Draw("same ][");
+        hDataR->Draw("same");
+        GetYaxis()->SetRangeUser(0.6,1.5);
+        GetYaxis()->SetNdivisions(404);
+        GetYaxis()->SetTitle("data/theory");
+        SetFTO({20}, {10}, {1.3, 1.5, 0.4, 3.4});
+
+        DrawLatexUp(-1.05, yBins[y]);
+    }
+
+    can->cd(1)->cd(3);
+    DrawLatexUp(1.3, Form("#alpha_{S} = %.3f : (#chi^{2} = HERA: %.1f, simple: %.1f, naive: %.1f)/ %d", as, chi2H, chi2S, chi2Naive, ndfT), 20, "c");
+
+
+    //Ratio to shifted theory
+    can->cd(2);
+    DividePad(vector<double>(nYbins,1.), {1});
+    for(int y = 0; y < nYbins; ++y) {
+        can->cd(2)->cd(y+1);
+        gPad->SetLogx();
+        auto hDataR = (TH1D*) hData[y]->Clone(rn());
+        auto hThShR = (TH1D*) hThShTot[y]->Clone(rn());
+        hDataR->Divide(hThShTot[y]);
+        hThShR->Divide(hThShTot[y]);
+
+        hDataR->SetLineColor(kBlack);
+        hThShR->SetLineColor(kBlue);
+        hThShR->Draw("][");
+        hDataR->Draw("same");
+        GetYaxis()->SetRangeUser(0.9,1.1);
+        GetYaxis()->SetTitle("data/theory'");
+        GetYaxis()->SetNdivisions(404);
+
+        DrawLatexUp(-1.2, Form("#chi_{p}^{2} = H: %.1f / %d", chi2NY[y]+ chi2LY[y], ndfY[y]),18);
+        DrawLatexDown(-1.2, Form("#chi^{2} = H: %.1f, S: %.1f/ %d",  chi2TotY[y], chi2STotY[y],  ndfY[y]),18);
+        SetFTO({20}, {10}, {1.3, 1.5, 0.4, 3.4});
+
+
+    }
+
+    //Shifts pt-spectra review
+    can->cd(3);
+    DividePad(vector<double>(nYbins,1.), {1});
+    for(int y = 0; y < nYbins; ++y) {
+        can->cd(3)->cd(y+1);
+        gPad->SetLogx();
+
+
+        auto hThShR = (TH1D*) hThShTot[y]->Clone(rn());
+        hThShR->Divide(hTh[y]);
+        for(int k = 1; k <= hThShR->GetNbinsX(); ++k)
+            hThShR->SetBinContent(k, hThShR->GetBinContent(k)-1);
+
+        hThShR->SetLineColor(kBlack);
+        hThShR->Draw("hist");
+
+
+        for(int s = 0; s < nTh; ++s) {
+            hShTh[s][y]->SetLineColor(kRed);
+            hShTh[s][y]->Draw("same ][");
+        }
+
+        for(int s = 0; s < nSys; ++s) {
+            if(shImp.count(s)) continue;
+            hShData[s][y]->SetLineColor(kOrange);
+            hShData[s][y]->Draw("same ][");
+        }
+        for(auto sEl : shImp) {
+            int s = sEl.first;
+            int c = sEl.second;
+            hShData[s][y]->SetLineColor(c);
+            hShData[s][y]->Draw("same ][");
+        }
+        hThShR->Draw("same");
+
+
+        GetYaxis()->SetRangeUser(-0.2,0.2);
+        GetYaxis()->SetNdivisions(404);
+        GetYaxis()->SetTitle("Rel. Unc.");
+        SetFTO({20}, {10}, {1.3, 1.5, 0.4, 3.4});
+
+
+        if(y == 1) {
+            auto leg = new TLegend(0.1, 0.05, 0.5, 0.35);
+            leg->SetBorderSize(0);
+            leg->SetTextSize(PxFontToRel(15));
+            leg->AddEntry(hThShR, "total shift", "l");
+            for(int k = 0; k < nTh; ++k) {
+                if(hShTh[k][y]->GetLineColor() == kRed) {
+                    leg->AddEntry(hShTh[k][y], "th. shifts", "l");
+                    break;
+                }
+            }
+            for(int k = 0; k < nSys; ++k) {
+                if(hShData[k][y]->GetLineColor() == kOrange) {
+                    leg->AddEntry(hShData[k][y], "data shifts", "l");
+                    break;
+                }
+            }
+            leg->Draw();
+            //DrawLegends({leg}, true);
+        }
+    }
+
+
+    //MAIN shifts pt-spectra review
+    can->cd(4);
+    DividePad(vector<double>(nYbins,1.), {1});
+    for(int y = 0; y < nYbins; ++y) {
+        can->cd(4)->cd(y+1);
+        gPad->SetLogx();
+
+        //Total shift
+        auto hThShR = (TH1D*) hThShTot[y]->Clone(rn());
+        hThShR->Divide(hTh[y]);
+        for(int k = 1; k <= hThShR->GetNbinsX(); ++k)
+            hThShR->SetBinContent(k, hThShR->GetBinContent(k)-1);
+
+
+        //Total PDF shift
+        auto hPDFTotSh = (TH1D*)hShTh[0][y]->Clone();
+        for(int s = 1; s < nTh; ++s) {
+            hPDFTotSh->Add(hShTh[s][y]);
+        }
+
+        //Total Sys shift (exclusing dominant)
+        auto hDataTotSh = (TH1D*)hShData[0][y]->Clone();
+        hDataTotSh->Reset();
+        for(int s = 0; s < nSys; ++s) {
+            if(shImp.count(s)) continue;
+            hDataTotSh->Add(hShData[s][y]);
+        }
+
+
+        hThShR->Draw("hist");
+
+
+        //Main shifts
+        for(auto sEl : shImp) {
+            int s = sEl.first;
+            int c = sEl.second;
+            hShData[s][y]->SetLineColor(c);
+            hShData[s][y]->Draw("same ][");
+        }
+
+        hPDFTotSh->SetLineColor(kRed);
+        hPDFTotSh->Draw("same ][");
+
+        hDataTotSh->SetLineColor(kOrange);
+        hDataTotSh->Draw("same ][");
+
+
+        hThShR->SetLineColor(kBlack);
+        hThShR->Draw("same ][");
+
+        GetYaxis()->SetRangeUser(-0.2,0.2);
+        GetYaxis()->SetNdivisions(404);
+        GetYaxis()->SetTitle("Rel. Unc.");
+        SetFTO({20}, {10}, {1.3, 1.5, 0.4, 3.4});
+
+        if(y == 1) {
+            auto leg = new TLegend(0.1, 0.05, 0.5, 0.25);
+            leg->SetTextSize(PxFontToRel(15));
+            leg->SetBorderSize(0);
+            //leg->AddEntry(hThShR, "total sh.", "l");
+            leg->AddEntry(hPDFTotSh, "PDF tot.", "l");
+            leg->AddEntry(hDataTotSh, "Data rest", "l");
+            //DrawLegends({leg}, true);
+            leg->Draw();
+        }
+
+
+    }
+
+
+    //Shifts
+    can->cd(5);
+
+    double chiSys = 0, chiTh = 0;
+    for(int i = 0; i < nSys; ++i)
+        chiSys += pow(shifts[i],2);
+    for(int i = 0; i < nTh; ++i)
+        chiTh  += pow(shifts[nSys+i],2);
+
+    hShifts->SetLineColor(kBlack);
+    hShifts->Draw();
+
+    //Draw important shifts with corresponding collors
+    for(auto s : shImp) {
+        auto hNow = (TH1D*) hShifts->Clone(rn());
+        for(int i = 1; i <= hNow->GetNbinsX(); ++i) {
+            if(i-1 != s.first) hNow->SetBinContent(i, -1000);
+        }
+        hNow->SetLineColor(s.second);
+        hNow->Draw("same");
+    }
+
+    SetFTO({20}, {10}, {1.3, 1.5, 0.4, 2.8});
+    GetYaxis()->SetRangeUser(-2.9, 3.6);
+    GetYaxis()->SetTitle("shift");
+    GetYaxis()->CenterTitle();
+
+    TLine *l = new TLine;
+    l->SetLineStyle(2);
+    l->DrawLine(nSys+0.5, -3, nSys+0.5, 4);
+    //l->DrawLine(1+0.5, -3, 1+0.5, 4);
+    l->DrawLine(0.5, -1, nSys+nTh+0.5, -1);
+    l->DrawLine(0.5,  1, nSys+nTh+0.5,  1);
+    DrawLatexUp(-1, Form("    NP+Data: #chi^{2} = %.1f / %d", chiSys, nSys), -1, "l");
+    DrawLatexUp(-1, Form("PDF: #chi^{2} = %.1f / %d   ", chiTh, nTh), -1, "r");
+    GetYaxis()->SetNdivisions(404);
+
+
+    int asI = round(1000*as);
+    int asF = round(1000* pdfAsVals.at(pdfName).front());
+    int asB = round(1000* pdfAsVals.at(pdfName).back());
+    if(asI == asF)
+        can->SaveAs("rew_"+pdfName+".pdf(");
+    else if(asI == asB)
+        can->SaveAs("rew_"+pdfName+".pdf)");
+    else
+        can->SaveAs("rew_"+pdfName+".pdf");
+}
@@ -0,0 +1,441 @@
+#ifndef asFitter_H
+#define asFitter_H
+
+//Fit of alphaS to the inclusive jet cross sections: data points, theory, nuisance solvers and chi2 definitions
+//The methods are compiled to libAsFitter.so (asFitter.cc), which is linked by fitTheory, fitServer and benchFitter
+//and loaded by the macros with R__LOAD_LIBRARY(libAsFitter.so)
+
+#include <iostream>
+#include <vector>
+#include <map>
+#include <set>
+#include <functional>
+
+#include "TString.h"
+#include "TH1D.h"
+#include "TGraph.h"
+#include "TMatrixD.h"
+#include "TVectorD.h"
+
+#include "tools.h"
+#include "theoryStore.h"
+#include "pdfUnc.h"
+#include "asSpline.h"
+#include "chi2Scan.h"
+#include "asExtract.h"
+#include "theorySource.h" //also fastNLO and LHAPDF for the live theory
+#include "rebin.h"
+
+using namespace std;
+
+extern vector<TString> ErrNames;           //names of the sources of the current data (after the decorrelation)
+extern const vector<TString> ErrNamesTable; //sources as in the data tables
+
+
+struct point {
+    double ptMin, ptMax;
+    double yMin, yMax;
+    double sigma;
+    double th;
+    double errStat, errSys, errTot, errUnc;
+    double errUncOrg; //uncorrelated error from the table
+    double errMerged = 0; //pruned correlated sources merged to the uncorrelated error
+    std::vector<double> errs, thErrs;//10 items
+};
+
+
+
+struct asFitter {
+    vector<point> data; //allDataPoints + potential theory predictions
+    //vector<double> th;
+    function<bool(const point&)> Cut; //selection function
+
+    //Theory xSections (NLO x NP x EW) of the central pdf member for each pdfName, tensor [alphaS][scaleVar][0][rap][ptBin]
+    map<TString, theoryStore>  thStores; 
+    TString thTag; //tag of the loaded theory, e.g. 16ak4
+    TString thShmKey; //shared-memory key of the loaded theory ("" for private storage)
+
+    //Relative pdf variations (m_i - m_0)/m_0 at alphaS=0.118, tensor [0][scaleVar][iPdf-1][rap][ptBin]
+    //loaded on the first fillTheory which profiles the pdf nuisances
+    map<TString, theoryStore>  pdfDeltas;
+    bool profilePDF = true;       //if false, no pdf nuisances are filled
+    bool pdfShareScales = false;  //use the variations of the central scale for all scale choices
+    map<TString, pdfErrType> pdfErrTypes; //hessian, symmhessian or replicas, for each pdfName
+
+    //Order used in fillTheory (nlo, nll or nnlo), k-factors are applied at gather time
+    TString order = "nll";
+    map<TString, vector<double>> kFactors; //[order] -> multiplier for each global bin of the store
+
+    //Splines in alphaS of the central predictions [pdfName][scale], used for alphaS values between the stored ones
+    map<TString, vector<asSpline>> thSplines;
+    double asStep = 0; //if > 0, the chi2 scans use this alphaS step instead of the stored values
+    bool writeGraphs = false; //scanAllChi2s writes also the TGraphs (one file per order and unCorr)
+    vector<int> scanScales = {0, 1, 2, 3, 4, 5, 6}; //scale choices scanned by scanAllChi2s
+    double yMaxCut = 1.6, ptMinCut = 95;           //selection of setCut, |y| and pt of the lower bin edges
+
+    //data point -> global bin of the theory store, for each pdfName
+    map<TString, vector<int>> binJoins;
+
+    //Datasets of the joint fit (empty for a single dataset read by readData)
+    //The points of all datasets are merged in data, the dataset-specific sources get the suffix @tag
+    //and are zero for the points of the other datasets
+    struct dataset {
+        TString tag;            //e.g. 16ak4 or 16ak7, selects also the theory
+        vector<TString> names;  //sources of the dataset after the decorrelation
+        vector<point> points;   //points with the errors of the dataset
+        int first = 0, last = 0;//range of the points in data
+    };
+    vector<dataset> sets;
+    vector<TString> sharedSources; //sources common to all datasets (before the _y decorrelation suffix)
+    theorySource *thSrc = nullptr;           //theory of the current dataset
+    map<TString, theorySource*> thSources;   //theory for each dataset tag
+    TString thSrcId;                         //identity of the current theory (theorySourceId), checked by the shared stores
+    map<TString, TString> thSrcIds;          //for each dataset tag
+
+    //If > 0, the pdf nuisances are compressed to the leading principal components
+    //which keep all but pdfCompressTol of the pdf variance of the selected points
+    double pdfCompressTol = 0;
+    int nPdfKept = -1; //number of kept components in the last compression
+
+    //Read data from the text file
+    static vector<point>  readData(TString fName, double unCorr = -1);
+
+    //Set the uncorrelated error of all points to unCorr [%], for unCorr <= 0 the value from the table is used
+    void setUnCorr(double unCorr);
+
+    //1,1,1,1 no docorrelation
+    //1,1,2,2 docorrelation to 2 bins
+    void Decorrelate(map<TString, vector<int>> decMap);
+
+    //Decorrelation map from the text: default, none or <source>:<group of y0>,..,<group of y3>;<source>:...
+    //returns false for a wrong text
+    static bool parseDecMap(TString dec, map<TString, vector<int>> &decMap);
+
+    //Add dataset tag (e.g. 16ak7) from the table fName to the joint fit, thFile is its theory (file or makeTheorySource spec)
+    //decMap as in Decorrelate, the sources listed in shared are common to all datasets
+    void addDataset(TString tag, TString fName, TString thFile, double unCorr, map<TString, vector<int>> decMap, vector<TString> shared);
+
+    //Merge the datasets to data and ErrNames, the sources are ordered [set0 specific]...[setN specific][shared]
+    void buildJoint();
+
+    //Read theory histograms of pdf member ipdf for pdfName, as and scale variation s, one per rapidity
+    //tag for example 16ak4 or 16ak7, if given the NP/EW corrections are applied (k-factors not)
+    vector<TH1D*> readMember(TString pdfName, double as, int s, int ipdf, TString tag = "");
+
+    //Get the k-factor (NLL or NNLO) for each global bin of the store, 1 for nlo
+    static vector<double> getKfactors(const theoryStore &st, TString tag, TString order);
+
+    //Errors of the theory reading and of the solvers: cout + exit(1), or runtime_error if throwOnError() (fitServer), see fatalError.h
+    [[noreturn]] static void fail(TString msg);
+
+    //Forget the theory of pdfName for dataset tag (stores, splines, bin joins), it is read again at the next use
+    void dropTheory(TString pdfName, TString tag);
+
+    //Attach st to the shared block key or, if it does not exist yet, set the layout, fill and publish it
+    //The block is made from the theory srcId, a block of another theory is not attached
+    //If the filling fails, the unfinished block is removed
+    //With empty key the store is filled to the private memory
+    static void openStore(theoryStore &st, TString key, TString srcId, function<void()> setLayout, function<void()> fill);
+    static set<TString> pendingStores; //blocks being filled, removed by fail()
+
+    //Key of the theory of pdfName for dataset tag, the first loaded tag uses the plain pdfName
+    TString thKey(TString pdfName, TString tag) const;
+
+    //Theory of the dataset tag, spec as in makeTheorySource (theory file, live:<table>, mock, store:..., interp:...)
+    //The first registered one is used also for the tags without own theory
+    void setTheory(TString tag, TString spec);
+
+    //Switch the theory to the one of the dataset tag (if registered by setTheory)
+    void useTheory(TString tag);
+    theorySource &getSource();
+
+    //Read the central theory histograms for alphaS values asList and nScl scale choices to the theory store
+    //If shmKey is given, the store is shared with other processes:
+    //the first one fills and publishes it, the others only attach to it
+    //The key contains a hash of the theory source and of the corrections file, so a changed theory gets a new block
+    //The pdf variations are loaded later by loadPdfDeltas
+    void loadTheory(TString pdfName, TString tag, vector<double> asList, int nScl, TString shmKey);
+
+    //Spline in alphaS of the central prediction for given theory key and scale choice (built once)
+    const asSpline &getAsSpline(TString thK, int scale);
+
+    //alphaS values of the chi2 scans, the stored ones or the range with step asStep
+    vector<double> getAsScan(TString pdfName) const;
+
+    //Pdf uncertainty type given by the theory source (guessed from the name for older theory files)
+    const pdfErrType &getPdfErrType(TString pdfName);
+
+    //Read the pdf variations at alphaS=0.118 and store them as relative deltas to the central member
+    //(the NP/EW corrections and k-factors cancel in the ratio)
+    //With pdfShareScales only the central scale is read and used for all scale choices
+    const theoryStore &loadPdfDeltas(TString pdfName, TString tag);
+
+    //Read theory histograms for PDF pdfName (all alphaS (as) and all scale choices (s))
+    void readAllTheory(TString pdfName, TString tag, TString shmKey = "");
+
+    //Read theory histograms for PDF pdfName 
+    void readSingleTheory(TString pdfName, TString tag, TString shmKey = "");
+
+
+    //Fill theory to the points in vector<points>, resutl contains also PDF unc.
+    void fillTheory(TString pdfName, double as, int scale = 0);
+
+    //Fill theory of the dataset tag to the points first, .., last-1
+    void fillTheory(TString pdfName, TString tag, int first, int last, double as, int scale);
+
+    //Replace the pdf nuisances by the leading principal components of the pdf covariance restricted to the selected points
+    //Components are kept until the discarded variance is below tol (fraction of the total), returns the discarded fraction
+    double compressPDF(double tol);
+
+
+    //Get number of points fulfilling the cuts
+    int getNpoints();
+
+
+    //Calculated according to https://arxiv.org/pdf/hep-ex/0012053.pdf
+    //Formula (33), page 29
+    double getChi2();
+    void printHighest(const TVectorD &s, int n);
+
+
+    double getChi2All();
+
+
+    //bool Cut(const point &p) { if(p.sigma == 0) return false;  return true;}
+
+
+    //Get the vector with the nuissence parameters (values which minimize chi2)
+    TVectorD getShifts();
+
+    //Get the vector with the nuissence parameters, including theor unc. (values which minimize chi2)
+    TVectorD getShiftsAll();
+
+    // HERA chi2 fit with theory unc
+    // http://www-h1.desy.de/psfiles/papers/desy15-039.pdf
+    TVectorD getShiftsHERAall();
+
+
+    // HERA chi2 fit with theory unc (with fixed shift)
+    // http://www-h1.desy.de/psfiles/papers/desy15-039.pdf
+    // iShift - idOf the fixed shift, shVal - its val
+    // Solved in the buffers of ws by Cholesky, the fixed shifts are decoupled as in getShiftsProducts
+    TVectorD getShiftsHERAall(const vector<int> &iShifts, const vector<double> &shVals);
+
+
+    //Selected points in the SoA form for the fused chi2 kernel
+    //E (nuisance vectors) and yBin are fixed within the scan, mu, m, stat2, unc2 are refreshed by updatePointsSoA
+    struct pointsSoA {
+        int n = 0, nErr = 0, nY = 0;
+        vector<int> yBin;                          //rapidity bin round(|2 yMin|)
+        vector<double> mu, m, stat2, unc2, eSum2;  //data, theory, squared rel. errors, sum of e^2
+        vector<double> E;                          //[source][point]
+    };
+
+    //Products of the nuisance vectors (data sys + pdf) of the selected points
+    //They depend neither on alphaS nor on the uncorrelated errors, so can be reused within the scan
+    struct nuisProducts {
+        int nErr = 0;
+        vector<int> idx;              //indexes of the selected points
+        vector<vector<double>> EE;    //packed upper triangle of e*e^T for each selected point
+        pointsSoA soa;
+    };
+    void fillPointsSoA(const vector<int> &idx, int nErr, pointsSoA &soa);
+    void updatePointsSoA(const vector<int> &idx, pointsSoA &soa);
+
+    struct chi2Fused {
+        double simple = 0, hera = 0, heraNoNP = 0, heraNoPDF = 0, naive = 0;
+        vector<double> heraLinY, heraLogY; //HERA chi2 of the rapidity bins (shifts sH, without the penalty), as getChi2HERAallPartial
+    };
+
+    //All chi2 variants in one pass over the points, the shifts which are not needed can be nullptr
+    //The points go in blocks of B, within a block the corrected residuals of all shift vectors are accumulated
+    //source by source (vectorised over the points), then the chi2 terms of the block are added
+    void getChi2Fused(const pointsSoA &pt, const TVectorD *sH, const TVectorD *sNP, const TVectorD *sPDF, const TVectorD *sS, bool naive, chi2Fused &res);
+    chi2Fused getChi2Fused(const pointsSoA &pt, const TVectorD *sH, const TVectorD *sNP, const TVectorD *sPDF, const TVectorD *sS, bool naive);
+
+    //withEE = false only selects the points (the products are not needed by getShiftsBlock)
+    nuisProducts getNuisProducts(bool withEE = true);
+
+    //Weights w and residuals d of the selected points, type "S" (simple) or "H" (HERA)
+    //The normal equations are then: mat = 1 + sum w e e^T, yVec = - sum w d e
+    void getWeights(const nuisProducts &np, TString type, vector<double> &w, vector<double> &d);
+
+    //Fill the normal matrix (full, including the unit prior) and the right-hand side from the products
+    void getNormalProducts(const nuisProducts &np, const vector<double> &w, const vector<double> &d, TMatrixD &mat, TVectorD &yVec);
+
+    //In-place Cholesky A = L L^T of the symmetric positive definite n x n matrix (row-major, the lower triangle is used)
+    static bool cholDecompose(double *A, int n);
+
+    //b -> L^-1 b
+    static void cholForward(const double *L, double *b, int n);
+
+    //b -> L^-T b
+    static void cholBackward(const double *L, double *b, int n);
+
+    //Get the nuisance parameters from the precomputed products, only the point weights are recalculated
+    //shifts with index in iFixed are fixed to zero, the result is written to sh (size nErr)
+    //The fixed shifts are decoupled (unit row and column, zero rhs), so the matrix keeps its size and the buffers of ws are reused
+    //The normal matrix 1 + sum w e e^T is positive definite, it is solved by the in-place Cholesky
+    void getShiftsProducts(const nuisProducts &np, const vector<double> &w, const vector<double> &d, const vector<int> &iFixed, TVectorD &sh);
+    TVectorD getShiftsProducts(const nuisProducts &np, const vector<double> &w, const vector<double> &d, const vector<int> &iFixed = {});
+
+    //Shifts of the joint fit from the normal equations assembled in the block form
+    //A point of dataset k depends only on the sources specific to k and on the shared ones (incl. pdf), i.e.
+    //    | A_k    B_k |
+    //    | B_k^T  C   |
+    //The specific blocks are eliminated one by one and only the Schur complement C - sum B_k^T A_k^-1 B_k is solved,
+    //the cost grows with the size of the shared block. Shifts with index in iFixed are fixed to zero
+    //All the blocks are in ws.blk and factorised by the in-place Cholesky, the result is written to sh
+    void getShiftsBlock(const nuisProducts &np, const vector<double> &w, const vector<double> &d, const vector<int> &iFixed, TVectorD &sh);
+    TVectorD getShiftsBlock(const nuisProducts &np, const vector<double> &w, const vector<double> &d, const vector<int> &iFixed = {});
+
+
+    //get the chi2 vale, the nuisence vector is as an input
+    double getChi2(const TVectorD &s);
+
+    //get the chi2 value, the nuisence vector is as an input, theor unc included
+    double getChi2All(const TVectorD &s);
+
+
+    //get the chi2 value, the nuisence vector is as an input, theor unc included
+    //Hera furmula http://www-h1.desy.de/psfiles/papers/desy15-039.pdf
+    double getChi2HERAall(const TVectorD &s);
+
+
+    //get the chi2 value, the nuisence vector is as an input, theor unc included
+    //Hera furmula http://www-h1.desy.de/psfiles/papers/desy15-039.pdf
+    double getChi2naive();
+
+
+    //With theory, but without correlated part
+    pair<double,double> getChi2HERAallPartial(const TVectorD &s);
+
+
+    //Get chi2 based on covariance matrix
+    //Cov = stat + unc + data sys (sources indx) + pdf, the buffers of ws are reused
+    double getChi2cov(const vector<int> &indx);
+
+
+    //Chi2 definitions, which can be requested together (bit mask)
+    enum chi2Type {
+        chi2Simple    = 1,  //nuisances, errors relative to data
+        chi2HERA      = 2,  //nuisances, HERA formula with log penalty
+        chi2HERAnoNP  = 4,  //as HERA, NP shifts fixed to 0
+        chi2HERAnoPDF = 8,  //as HERA, pdf shifts fixed to 0
+        chi2Naive     = 16, //all errors added in quadrature
+        chi2Cov       = 32  //covariance matrix (data sys from covIndx + pdf)
+    };
+
+    struct chi2Result {
+        double simple = 0, hera = 0, heraNoNP = 0, heraNoPDF = 0, naive = 0, cov = 0;
+    };
+
+    //Preallocated buffers of the solvers and of the chi2 evaluation
+    //They are sized once for the number of nuisances and reused by all the calls of a scan (no heap allocation in the loop)
+    struct solverWork {
+        int nErr = -1;
+        TMatrixD matF, mat;           //normal matrix from the products, the one solved (fixed shifts decoupled)
+        TVectorD yVecF;               //right-hand side
+        vector<int> iNP, iPDF;        //NP and pdf shifts (fixed in the noNP and noPDF variants)
+        vector<double> w, d;          //point weights and residuals
+        TVectorD sH, sNP, sPDF, sS;   //shifts of the chi2 variants
+        chi2Fused fused;
+        vector<int> cIdx;             //covariance chi2: selected points, matrix and residuals
+        vector<double> cov, diff;
+        struct {                      //block solver of the joint fit (getShiftsBlock), row-major
+            vector<int> of, pos;      //dataset of each nuisance (-1 shared), index within its block
+            vector<vector<int>> spec; //nuisances specific to each dataset
+            vector<int> shared;
+            vector<vector<double>> A, Bt, Xt, z; //per dataset: A_k, B_k^T, (A_k^-1 B_k)^T, y_k -> A_k^-1 y_k
+            vector<double> C, yS, eK, eS;        //shared block and its right-hand side, errors of a point
+        } blk;
+    };
+    solverWork ws;
+    void initWork(int nErr);
+
+    //Shifts from the products, the joint fit uses the block solver
+    void solveShifts(const nuisProducts &np, const vector<double> &w, const vector<double> &d, const vector<int> &iFixed, TVectorD &sh);
+
+    //Evaluate only the requested chi2 definitions (for the current Cut and theory)
+    //The nuisance products np are filled at the first call, so they are shared between the calls of a scan
+    //(the caller resets np when the Cut or the pdf changes), the HERA weights are shared by the HERA variants
+    chi2Result getChi2s(int types, nuisProducts &np, const vector<int> &covIndx = {});
+    chi2Result getChi2s(int types, const vector<int> &covIndx = {});
+
+
+    //fill the theory from file to histos and get chi2 wrt data
+    double calcChi2(TString pdfName, double as, int scale = 0);
+
+    //only the requested chi2 definitions (chi2Type mask) are evaluated
+    chi2Result calcChi2(TString pdfName, double as, int scale, int types);
+
+
+    void ScanChi2(TString pdfName, int scale = 0);
+
+
+    //print the chi2 table
+    void printChi2Table();
+    void printAsY(int y);
+    void printAsPt(int pt);
+    TGraph *getFitGraphPt(TString pdfName, int pt, int scale);
+
+
+    //type = all, noNP, noPDF
+    vector<TGraph*> getFitGraphs(TString pdfName, int y, int scale);
+
+    //Set the Cut to rapidity bin y and pt bin ipt (-1 means all)
+    void setCut(int y, int ipt);
+
+    //type = all, noNP, noPDF
+    //Graphs for each of the unCorr values, the products of the nuisance vectors are shared among
+    //all alphaS and unCorr values, only the diagonal weights are recalculated
+    vector<vector<vector<TGraph*>>> getFitGraphsAll(TString pdfName, int y, int ipt, int scale, const vector<double> &unCorrs);
+
+
+    //Names of the loaded pdfs (the theories of the other datasets have the same pdfs)
+    vector<TString> getPdfNames() const;
+
+    //Scan chi2s for all orders and unCorr values, the loaded theory and the data-theory joins are shared
+    //unCorr <= 0 means the uncorrelated errors from the table
+    //The results are stored in the columnar table fName (see chi2Scan.h), with writeGraphs also as graphs
+    void scanAllChi2s(vector<TString> orders, vector<double> unCorrs, TString fName = "chi2Anal/chi2scan.root");
+    void scanAllChi2s(TString orderNow, vector<double> unCorrs, chi2ScanWriter &out);
+    void getAllChi2s();
+
+
+    //Closed-form pol4 fit to the chi2 graph (asExtract.h)
+    static asFitResult getAsFit(TGraph *gr);
+
+    //Position of the minimum of the pol4 fit to the chi2 graph
+    static double getAsMin(TGraph *gr);
+
+    //Attach the fitted pol4 to the graph, so it is drawn and stored with it
+    static void addAsFit(TGraph *gr);
+
+    //Leave-one-point-out influence of the selected points (Cut) on the HERA chi2 and the fitted alphaS
+    //The normal matrix is factorised once per alphaS, removal of a point is a Sherman-Morrison rank-one downdate:
+    //  A_q = A - w_q e_q e_q^T,  s_q = s + A^{-1} e_q * w_q (d_q + e_q.s) / (1 - w_q e_q.A^{-1}e_q)
+    //  chi2_q = sum_{p!=q} (w_p d_p^2 + log_p) - b_q.s_q
+    void influenceAnalysis(TString pdfName, int scale = 0);
+
+    //HERA chi2 for all alphaS values of the pdf and the fitted alphaS (for the current Cut)
+    double fitAsHERA(TString pdfName, int scale = 0);
+
+    //Rank the experimental sources by their contribution to the profiled HERA chi2 at alphaS = 0.118:
+    //dChi2 = chi2(source fixed to zero) - chi2(all), returned in increasing order
+    //The NP and pdf nuisances are not ranked, so they are never pruned
+    vector<pair<double,int>> rankSources(TString pdfName, int scale = 0);
+
+    //Remove the experimental sources with dChi2 < threshold (for the current Cut)
+    //With merge the removed sources are added in quadrature to the uncorrelated error
+    //With verify the alphaS shift caused by the pruning is reported
+    void pruneSources(TString pdfName, double threshold, bool merge, bool verify, int scale = 0);
+    void fitAs(TString pdfName, int y);
+
+			
+    //
+    void TheoryPlotter();
+    void plotReview(TString pdfName, double as, int scale = 0);
+};
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef asSpline_H
+#define asSpline_H
+
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+
+#include "fatalError.h"
+
+//Natural cubic spline in alphaS, evaluated for many bins at once
+//The values are given on a grid of alphaS values, [node][bin] in one flat vector
+//The tridiagonal system depends only on the grid, so it is eliminated once for all bins
+struct asSpline {
+    std::vector<double> x;    //alphaS grid (increasing)
+    int nB = 0;               //number of bins
+    std::vector<double> y, m; //values and second derivatives, [node][bin]
+
+    asSpline() {}
+    asSpline(const std::vector<double> &xGrid, const std::vector<double> &vals) { init(xGrid, vals); }
+
+    void init(const std::vector<double> &xGrid, const std::vector<double> &vals)
+    {
+        x = xGrid;
+        int n = x.size();
+        if(n == 0 || vals.size() % n != 0) {
+            fatalError("asSpline: wrong number of values");
+        }
+        nB = vals.size() / n;
+        y = vals;
+        m.assign(vals.size(), 0.);
+        if(n < 3) return; //constant or linear
+
+        //Thomas algorithm for h[i-1] M[i-1] + 2(h[i-1]+h[i]) M[i] + h[i] M[i+1] = rhs[i], M[0] = M[n-1] = 0
+        std::vector<double> h(n-1), c(n), diag(n);
+        for(int i = 0; i < n-1; ++i)
+            h[i] = x[i+1] - x[i];
+        for(int i = 1; i < n-1; ++i) {
+            diag[i] = 2*(h[i-1] + h[i]) - (i > 1 ? h[i-1]*c[i-1] : 0);
+            c[i]    = h[i] / diag[i];
+        }
+        for(int i = 1; i < n-1; ++i) {
+            double *mi = &m[size_t(i)*nB];
+            const double *mp = &m[size_t(i-1)*nB];
+            const double *y0 = &y[size_t(i-1)*nB], *y1 = &y[size_t(i)*nB], *y2 = &y[size_t(i+1)*nB];
+            for(int b = 0; b < nB; ++b) {
+                double rhs = 6*((y2[b] - y1[b])/h[i] - (y1[b] - y0[b])/h[i-1]);
+                mi[b] = (rhs - (i > 1 ? h[i-1]*mp[b] : 0)) / diag[i];
+            }
+        }
+        for(int i = n-3; i >= 1; --i) {
+            double *mi = &m[size_t(i)*nB];
+            const double *mn = &m[size_t(i+1)*nB];
+            for(int b = 0; b < nB; ++b)
+                mi[b] -= c[i] * mn[b];
+        }
+    }
+
+    //Values of all bins at alphaS as, O(bins)
+    void eval(double as, double *out) const
+    {
+        int n = x.size();
+        if(n == 1) {
+            std::copy(y.begin(), y.end(), out);
+            return;
+        }
+        if(as < x.front() - 1e-9 || as > x.back() + 1e-9) {
+            fatalError("asSpline: alphaS " + std::to_string(as) + " outside of the grid " + std::to_string(x.front()) + " " + std::to_string(x.back()));
+        }
+        int i = std::upper_bound(x.begin(), x.end(), as) - x.begin() - 1;
+        i = std::max(0, std::min(n-2, i));
+
+        double h = x[i+1] - x[i];
+        double a = (x[i+1] - as) / h;
+        double b = (as - x[i]) / h;
+        double ca = (a*a*a - a) * h*h / 6;
+        double cb = (b*b*b - b) * h*h / 6;
+        const double *y0 = &y[size_t(i)*nB], *y1 = &y[size_t(i+1)*nB];
+        const double *m0 = &m[size_t(i)*nB], *m1 = &m[size_t(i+1)*nB];
+        for(int k = 0; k < nB; ++k)
+            out[k] = a*y0[k] + b*y1[k] + ca*m0[k] + cb*m1[k];
+    }
+
+    std::vector<double> eval(double as) const
+    {
+        std::vector<double> v(nB);
+        eval(as, v.data());
+        return v;
+    }
+};
+
+
+#endif
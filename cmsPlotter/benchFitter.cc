@@ -0,0 +1,126 @@
+//Microbenchmarks of the asFitter kernels on synthetic data (no tables, LHAPDF sets or theory files needed)
+//  ./benchFitter [--points=200] [--sources=34] [--pdf=28] [--time=0.5] [--seed=1] [--out=bench.json]
+//The points are spread over 4 rapidity bins with log-spaced pt bins. The sources are smooth functions of pt and y,
+//so the bins are strongly correlated as for the JES sources, the data are fluctuated by one random draw of them.
+//The pdf eigenvectors (asymmetric hessian pairs) grow with x ~ 2 pt cosh(y) / sqrt(s).
+//Every kernel is repeated for at least --time seconds, the results are written as JSON (stdout without --out)
+#include "asFitter.h" //libAsFitter.so
+#include "synthData.h"
+
+#include <chrono>
+#include <random>
+#include <fstream>
+
+struct benchResult {
+    TString name;
+    long long n;
+    double sec;
+};
+
+double benchSink = 0; //results of the kernels are accumulated here, so they are not optimised out
+
+//Run f in batches of doubling size until minTime is reached
+template<typename F>
+benchResult bench(TString name, double minTime, F f)
+{
+    f(); //warm-up, lazy initialisations
+    long long n = 0, batch = 1;
+    auto t0 = chrono::steady_clock::now();
+    double el = 0;
+    while(el < minTime) {
+        for(long long i = 0; i < batch; ++i)
+            f();
+        n += batch;
+        batch *= 2;
+        el = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    }
+    cerr << name << " : " << n/el << " evals/s" << endl;
+    return {name, n, el};
+}
+
+
+int main(int argc, char** argv)
+{
+    synthConfig cfg;
+    TString outName;
+    for(int i = 1; i < argc; ++i) {
+        TString a = argv[i];
+        int eq = a.First('=');
+        TString key = eq > 0 ? TString(a(0, eq)) : a;
+        TString val = eq > 0 ? TString(a(eq+1, a.Length())) : "";
+        if(key == "--points")       cfg.nPoints = val.Atoi();
+        else if(key == "--sources") cfg.nSrc    = val.Atoi();
+        else if(key == "--pdf")     cfg.nPdf    = val.Atoi();
+        else if(key == "--time")    cfg.minTime = val.Atof();
+        else if(key == "--seed")    cfg.seed    = val.Atoi();
+        else if(key == "--out")     outName     = val;
+        else {
+            cout << "Usage: " << argv[0] << " [--points=200] [--sources=34] [--pdf=28] [--time=0.5] [--seed=1] [--out=bench.json]" << endl;
+            return 1;
+        }
+    }
+
+    const TString pdfName = "CT14nnlo"; //only the alphaS grid of the set is used
+    asFitter fit;
+    makeSynthetic(fit, cfg, pdfName);
+    fit.fillTheory(pdfName, 0.118);
+    int nErr = fit.data[0].errs.size() + fit.data[0].thErrs.size();
+
+    vector<int> allSrc;
+    for(int j = 0; j < cfg.nSrc; ++j)
+        allSrc.push_back(j);
+
+    vector<benchResult> res;
+    double t = cfg.minTime;
+
+    res.push_back(bench("fillTheory",         t, [&]() { fit.fillTheory(pdfName, 0.118); benchSink += fit.data[0].th; }));
+    res.push_back(bench("fillTheorySpline",   t, [&]() { fit.fillTheory(pdfName, 0.1183); benchSink += fit.data[0].th; }));
+    fit.fillTheory(pdfName, 0.118);
+
+    TVectorD shS = fit.getShiftsAll();
+    TVectorD shH = fit.getShiftsHERAall();
+    res.push_back(bench("getShiftsAll",       t, [&]() { benchSink += fit.getShiftsAll()(0); }));
+    res.push_back(bench("getShiftsHERAall",   t, [&]() { benchSink += fit.getShiftsHERAall()(0); }));
+    res.push_back(bench("getShiftsHERAallFixed", t, [&]() { benchSink += fit.getShiftsHERAall({0, 1}, {0., 0.})(2); }));
+    res.push_back(bench("getChi2All",         t, [&]() { benchSink += fit.getChi2All(shS); }));
+    res.push_back(bench("getChi2HERAall",     t, [&]() { benchSink += fit.getChi2HERAall(shH); }));
+    res.push_back(bench("getChi2naive",       t, [&]() { benchSink += fit.getChi2naive(); }));
+    res.push_back(bench("getChi2cov",         t, [&]() { benchSink += fit.getChi2cov(allSrc); }));
+
+    asFitter::nuisProducts np = fit.getNuisProducts();
+    vector<double> w, d;
+    fit.getWeights(np, "H", w, d);
+    TVectorD sh(np.nErr);
+    res.push_back(bench("getNuisProducts",    t, [&]() { benchSink += fit.getNuisProducts().nErr; }));
+    res.push_back(bench("getShiftsProducts",  t, [&]() { fit.getShiftsProducts(np, w, d, {}, sh); benchSink += sh(0); }));
+    res.push_back(bench("getChi2Fused",       t, [&]() { benchSink += fit.getChi2Fused(np.soa, &shH, nullptr, nullptr, &shS, true).hera; }));
+
+    const int types = asFitter::chi2HERA | asFitter::chi2HERAnoNP | asFitter::chi2HERAnoPDF | asFitter::chi2Simple | asFitter::chi2Naive;
+    res.push_back(bench("getChi2sScanPoint",  t, [&]() { benchSink += fit.getChi2s(types, np).hera; }));
+
+    //JSON report
+    stringstream js;
+    js << "{\n";
+    js << "  \"benchmark\": \"asFitter\",\n";
+    js << "  \"config\": {\"points\": " << fit.data.size() << ", \"sources\": " << cfg.nSrc << ", \"pdfEigen\": " << cfg.nPdf
+       << ", \"nuisances\": " << nErr << ", \"minTime\": " << cfg.minTime << ", \"seed\": " << cfg.seed << "},\n";
+    js << "  \"results\": [\n";
+    for(int i = 0; i < res.size(); ++i) {
+        const auto &r = res[i];
+        js << "    {\"name\": \"" << r.name << "\", \"evaluations\": " << r.n << ", \"seconds\": " << r.sec
+           << ", \"evalsPerSec\": " << r.n / r.sec << ", \"usPerEval\": " << 1e6 * r.sec / r.n << "}"
+           << (i+1 < res.size() ? "," : "") << "\n";
+    }
+    js << "  ],\n";
+    js << "  \"sink\": " << benchSink << "\n";
+    js << "}\n";
+
+    if(outName == "")
+        cout << js.str();
+    else {
+        ofstream out(outName.Data());
+        out << js.str();
+        cerr << "Results written to " << outName << endl;
+    }
+    return 0;
+}
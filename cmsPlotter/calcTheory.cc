@@ -12,17 +12,22 @@
 #include <cmath>
 #include <cstdlib>
 #include <cfloat>
+#include <set>
 //#include "fastnlotk/fastNLODiffReader.h"
 //#include "fastNLODiffAlphas.h"
-#include "fastnlotk/fastNLOAlphas.h"
 
 #include "TH1D.h"
 #include "TCanvas.h"
 #include "TStyle.h"
 #include "TFile.h"
+#include "TNamed.h"
 
 #include "plottingHelper.h"
 #include "tools.h"
+#include "pdfUnc.h"
+#include "asSpline.h"
+#include "rebin.h" //libAsFitter.so
+#include "theoryProvider.h" //also fastNLO and LHAPDF, unless NO_FASTNLO
 
 using namespace PlottingHelper;
 
@@ -39,79 +44,71 @@ TString rn() {return Form("%d",rand());}
 using namespace std;
 
 //All functions to have a list
-vector<TH1D*> readHisto(fastNLOAlphas &fnlo);
-vector<vector<TH1D*>> getScaleuncHistos(fastNLOAlphas &fnlo);
-vector<vector<TH1D*>> getAsScaleuncHistos(TString pdfName, int R);
-vector<vector<TH1D*>> getPDFuncHistos(fastNLOAlphas &fnlo);
+vector<TH1D*> readHisto(theoryProvider &fnlo);
+vector<vector<TH1D*>> getScaleuncHistos(theoryProvider &fnlo);
+vector<vector<TH1D*>> getPDFuncHistos(theoryProvider &fnlo);
 //vector<vector<TH1D*>> getAsHistos(fastNLOAlphas &fnlo);
-TH1D *rebin(TH1D *h, TH1D *hTemp);
 void printHisto(TH1D *h);
 void SaveHistos(vector<vector<TH1D*>> hist,  TString tag);
 void SaveHistosByTitle(vector<vector<TH1D*>> hist);
-void scanAsToFile(int R);
+void scanAsToFile(int R, vector<TString> pdfList, TString outName, int iShard = 0, int nShards = 1);
+TString getShardName(TString outName, int iShard, int nShards);
+bool getMpiShard(int &iShard, int &nShards);
+uint64_t fnv1a(const TString &s);
 vector<vector<vector<TH1D*>>> calcXsections(int R, TString pdfName);
 
-TString getLHAname(TString pdfName, int asI);
+pdfErrType getErrType(TString lhaName);
+int getNmembers(TString lhaName);
+theoryProvider *makeProvider(TString table, TString lhaName);
+TString getTableName(int R);
 
+//One evaluation of the alphaS scan: pdf set, alphaS x 1000, scale choice (scaleChoices) and pdf member
+struct scanTask {
+    TString pdf;
+    int asI, scale, member;
 
+    //name of the histogram of the rapidity bin y in the theory file
+    TString getTitle(int y) const { return pdf + Form("_y%d_as0%d_scale%d_pdf%d", y, asI, scale, member); }
+};
+vector<scanTask> getScanTasks(vector<TString> pdfList);
+vector<vector<TString>> runScanTasks(int R, const vector<scanTask> &tasks, int first, int last);
 
-//Read 2D histogram to the vector, index is rapidity, theory is given by fnlo
-//Histograms have no error
-vector<TH1D*> readHisto(fastNLOAlphas &fnlo)
-{
-    //fnlo.SetScaleFactorsMuRMuF(1.0, 1.0);
-    fnlo.CalcCrossSection();
-    vector<double> xs = fnlo.GetCrossSection();
-    
-    map<double, vector<double>> bins, xSec;
-    for(int k = 0; k < xs.size(); ++k) {
-        //cout << "Helenka " << k <<" "<< fnlodiff.GetObsBinLoBound(k,0) << endl;
-        double etaDn = fnlo.GetObsBinLoBound(k,0);
-        double ptDn  = fnlo.GetObsBinLoBound(k,1);
-        double etaUp = fnlo.GetObsBinUpBound(k,0);
-        double ptUp  = fnlo.GetObsBinUpBound(k,1);
-
-        bins[etaDn].push_back(ptDn);
-        if(k == xs.size() - 1 || fnlo.GetObsBinLoBound(k,0) != fnlo.GetObsBinLoBound(k+1,0))
-            bins[etaDn].push_back(ptUp);
-
-        xSec[etaDn].push_back(xs[k]);
-        //cout << etaAvg <<" "<<ptAvg << " "<< xs[0][k] <<" "<< xs[1][k] <<" "<< xs[2][k] <<" "<< xs[2][k]<<  endl;
-    }
-    //cout << "First part done" << endl;
 
-    vector<TH1D*> hists;
-    for(auto obj : bins) {
-        double etaDn = obj.first;
-        vector<double> binning = obj.second;
+bool useMock = false; //synthetic theory (--mock) instead of fastNLO + LHAPDF
 
-        TH1D * h = new TH1D(rn(), Form("%g", etaDn), binning.size()-1, binning.data());
-
-        //cout << etaDn << endl;
+//Theory of the table and pdf set, fastNLO or the mock (--mock or build with NO_FASTNLO)
+theoryProvider *makeProvider(TString table, TString lhaName)
+{
+    INSTR_SCOPE("tableLoad");
+#ifndef NO_FASTNLO
+    if(!useMock)
+        return new fastNLOProvider(table, lhaName);
+#endif
+    return new mockProvider(table, lhaName);
+}
 
-        for(int i = 0; i < xSec.at(etaDn).size(); ++i) {
-            h->SetBinContent(i+1, xSec.at(etaDn)[i]);
-            h->SetBinError(i+1, 0);
-        }
+TString getTableName(int R)
+{
+    if(R == 4)      return "theorFiles/InclusiveNJets_fnl5362h_v23_fix.tab";
+    else if(R == 7) return "theorFiles/InclusiveNJets_fnl5332h_v23_fix.tab";
+    cout << "Wrong jet radius " << R << endl;
+    exit(1);
+}
 
-        hists.push_back(h);
-    }
 
-    /*
-    cout << "Second part done Start" << endl;
-    for(int i = 0; i < hists.size(); ++i)
-        hists[i]->Print();
-    cout << "Second part done End " << hists.size() <<  endl;
-    */
 
-    return hists;
+//Read 2D histogram to the vector, index is rapidity, theory is given by fnlo
+//Histograms have no error
+vector<TH1D*> readHisto(theoryProvider &fnlo)
+{
+    return getBinnedHistos(fnlo, fnlo.calcCrossSection());
 }
 
 //Get vector of histograms which includes scale unc
 //(cnt, scaleUp, scaleDn)
-vector<vector<TH1D*>> getScaleuncHistos(fastNLOAlphas &fnlo)
+vector<vector<TH1D*>> getScaleuncHistos(theoryProvider &fnlo)
 {
-    fnlo.SetLHAPDFMember(0);
+    fnlo.setMember(0);
 
     vector<vector<double>> scales = { { 1, 1},
                               { 2, 2},
@@ -124,8 +121,7 @@ vector<vector<TH1D*>> getScaleuncHistos(fastNLOAlphas &fnlo)
 
     vector<vector<TH1D*>> histos;
     for(auto  s : scales) {
-        fnlo.SetScaleFactorsMuRMuF(s[0], s[1]);
-        auto hh = readHisto(fnlo);
+        fnlo.setScaleFactors(s[0], s[1]);
         //cout << "RAdek before " << hh.size() << endl;
         histos.push_back(readHisto(fnlo));
     }
@@ -166,214 +162,198 @@ vector<vector<TH1D*>> getScaleuncHistos(fastNLOAlphas &fnlo)
 }
 
 
-TString getLHAname(TString pdfName, int asI)
+//R = 4 or R = 7
+//Tasks of the alphaS scan, one evaluation each: all alphaS values of the pdf set and all scale choices,
+//at alphaS = 0.118 also all pdf members. The order is the one of the output file and it is the same in all shards
+vector<scanTask> getScanTasks(vector<TString> pdfList)
 {
-    TString tag1, tag2;
-    if(pdfName == "CT14nlo") {
-        tag1 = "CT14nlo_as_0";
-    } else if(pdfName == "CT14nnlo") {
-        tag1 = "CT14nnlo_as_0";
-
-    } else if(pdfName == "HERAPDF20_NLO") {
-        tag1 = "HERAPDF20_NLO_ALPHAS_";
-    } else if(pdfName == "HERAPDF20_NNLO") {
-        tag1 = "HERAPDF20_NNLO_ALPHAS_";
-
-    } else if(pdfName == "NNPDF31_nlo") {
-        tag1 = "NNPDF31_nlo_as_0";
-    } else if(pdfName == "NNPDF31_nnlo") {
-        tag1 = "NNPDF31_nnlo_as_0";
-
-    } else if(pdfName == "ABMP16_5_nlo") {
-        tag1 = "ABMP16als";
-        tag2 = "_5_nlo";
-    } else if(pdfName == "ABMP16_5_nnlo") {
-        tag1 = "ABMP16als";
-        tag2 = "_5_nnlo";
-    } else if(pdfName == "MMHT2014nlo68cl" || "MMHT2014nnlo68cl") {
-        return pdfName;
-    }
-    else
-        exit(1);
-
-    TString whole = tag1 + Form("%d", asI) + tag2;
-
-    if(asI == 118) {
-        if(pdfName.Contains("CT14")) 
-            whole = pdfName;
-        else if(pdfName.Contains("HERAPDF20_"))
-            whole = pdfName + "_EIG";
-        else if(pdfName.Contains("NNPDF31_nlo"))
-            whole = "NNPDF31_nlo_as_0118_hessian";
-        else if(pdfName.Contains("NNPDF31_nnlo"))
-            whole = "NNPDF31_nnlo_as_0118_hessian";
-    }
-    if(pdfName.Contains("MMHT2014"))
-        whole = pdfName;
-
-    return whole;
+    vector<scanTask> tasks;
+    for(auto pdf : pdfList)
+        for(double as : pdfAsVals.at(pdf)) {
+            int asI = round(as * 1000);
+            int nPDFs = (asI == 118) ? getNmembers(getLHAname(pdf, asI)) : 1;
+            for(int s = 0; s < 7; ++s)
+                for(int m = 0; m < nPDFs; ++m)
+                    tasks.push_back({pdf, asI, s, m});
+        }
+    return tasks;
 }
 
-
-
-
-//R = 4 or R = 7
-vector<vector<TH1D*>> getAsScaleuncHistos(TString pdfName, int R)
+//Evaluate the tasks [first, last) and write their histograms (one per rapidity) to the current file
+//The provider is kept while the pdf set and alphaS stay the same, returns the names of the written histograms per task
+vector<vector<TString>> runScanTasks(int R, const vector<scanTask> &tasks, int first, int last)
 {
-    //fnlo.SetLHAPDFMember(0);
-
-    vector<vector<double>> scales = { { 1, 1},
-                              { 2, 2},
-                              { 0.5, 0.5},
-                              { 1, 2},
-                              { 1, 0.5},
-                              { 2, 1},
-                              { 0.5, 1} };
-
-    /*
-    map<TString, vector<double> > pdfAsVals;
-    pdfAsVals["CT14nlo"] = getRange(0.111, 0.123);
-    pdfAsVals["CT14nnlo"] = pdfAsVals["CT14nlo"];
+    vector<vector<TString>> names;
+    theoryProvider *prov = nullptr;
+    TString provSet;
+    for(int t = first; t < last; ++t) {
+        const scanTask &tk = tasks[t];
+        TString lha = getLHAname(tk.pdf, tk.asI);
+        if(!prov || lha != provSet) {
+            delete prov;
+            prov = makeProvider(getTableName(R), lha);
+            prov->setAlphasMz(tk.asI / 1000.);
+            provSet = lha;
+            cout << "Task " << t << " : " << tk.pdf << " " << lha << " " << prov->getNmembers() << endl;
+        }
+        prov->setMember(tk.member);
+        prov->setScaleFactors(scaleChoices[tk.scale][0], scaleChoices[tk.scale][1]);
+        vector<TH1D*> hh = readHisto(*prov);
+
+        names.emplace_back();
+        INSTR_SCOPE("rootWrite");
+        for(int y = 0; y < hh.size(); ++y) {
+            TString n = tk.getTitle(y);
+            hh[y]->SetTitle(n);
+            hh[y]->SetName(n);
+            hh[y]->Write(n);
+            names.back().push_back(n);
+            delete hh[y];
+        }
+    }
+    delete prov;
+    return names;
+}
 
-    pdfAsVals["HERAPDF20_NLO"] = getRange(0.111, 0.123);
-    pdfAsVals["HERAPDF20_NNLO"] = pdfAsVals["HERAPDF20_NLO"];
 
-    pdfAsVals["NNPDF31_nnlo"] = {0.112, 0.114, 0.116, 0.117, 0.118, 0.119, 0.120,  0.122};
-    */
 
 
-    cout << "Radek " << endl;
-    vector<vector<TH1D*>> histos;
-    for(double as : pdfAsVals.at(pdfName)) {
-        int asI = round(as * 1000);
-
-        TString whole = getLHAname(pdfName, asI);
-
-        TString inFile;
-        if(R == 4)      inFile = "theorFiles/InclusiveNJets_fnl5362h_v23_fix.tab";
-        else if(R == 7) inFile = "theorFiles/InclusiveNJets_fnl5332h_v23_fix.tab";
-        else assert(1);
-
-        fastNLOAlphas  fnlo(inFile.Data(), whole.Data(), 0);
-        //fastNLOAlphas  fnlo("theorFiles/suman/Fnlo_AK7_Eta1.tab", whole.Data(), 0);
-        fnlo.SetAlphasMz(as, true);
-
-        //cout << "Helenka " << as << endl;
-
-        int sId = 0;
-        for(auto  s : scales) {
-            int nPDFs = fnlo.GetNPDFMembers();
-            cout << sId << " "<< pdfName<<" : "<< whole <<" "<< nPDFs << endl;
-            if(asI != 118)
-                nPDFs = 1;
-            for(int pdfId = 0; pdfId < nPDFs; ++pdfId) {
-                fnlo.SetLHAPDFMember(pdfId);
-                fnlo.SetScaleFactorsMuRMuF(s[0], s[1]);
-                auto hh = readHisto(fnlo);
-
-                for(int y = 0; y < hh.size(); ++y)
-                    hh[y]->SetTitle(pdfName + Form("_y%d_as0%d_scale%d_pdf%d", y, asI, sId, pdfId));
-
-                //cout << "RAdek before " << hh.size() << endl;
-                histos.push_back(hh);
-            }
-
-            ++sId;
-        }
-        cout << "Helenka end" << endl;
+//Pdf uncertainty type of the LHAPDF set from its metadata (ErrorType, ErrorConfLevel)
+pdfErrType getErrType(TString lhaName)
+{
+#ifndef NO_FASTNLO
+    if(!useMock) {
+        const LHAPDF::PDFSet &set = LHAPDF::getPDFSet(lhaName.Data());
+        return pdfErrType::fromInfo(set.errorType(), set.errorConfLevel(), set.size());
     }
-    //exit(0);
-
-    return histos;
+#endif
+    return mockProvider("", lhaName).getErrType();
 }
 
-
+//Number of members of the LHAPDF set (from its metadata, the grids are not loaded)
+int getNmembers(TString lhaName)
+{
+#ifndef NO_FASTNLO
+    if(!useMock)
+        return LHAPDF::getPDFSet(lhaName.Data()).size();
+#endif
+    return mockProvider("", lhaName).getNmembers();
+}
 
 
 //Get histogram including up and dn pdf variation 
-vector<vector<TH1D*>> getPDFuncHistos(fastNLOAlphas &fnlo)
+//The members are folded one by one to the accumulators, only the central histograms are kept
+vector<vector<TH1D*>> getPDFuncHistos(theoryProvider &fnlo)
 {
-    fnlo.SetLHAPDFMember(0);
-    fnlo.SetScaleFactorsMuRMuF(1, 1);
+    fnlo.setMember(0);
+    fnlo.setScaleFactors(1, 1);
 
-    int nPDFs = fnlo.GetNPDFMembers();
-    TString pdfName = fnlo.GetLHAPDFFilename();
-    cout << pdfName << endl;
-    double Fact = pdfName.Contains("CT14") ? 1.645 : 1;
+    int nPDFs = fnlo.getNmembers();
+    TString pdfName = fnlo.getPdfSetName();
+    pdfErrType et = getErrType(pdfName);
+    cout << pdfName <<" "<< et.toString() << endl;
 
-    vector<vector<TH1D*>> histos;
+    vector<TH1D*> hCnt;
+    vector<pdfUncAccumulator> acc;
     for(int i = 0; i < nPDFs; ++i) {
-        fnlo.SetLHAPDFMember(i);
-        histos.push_back(readHisto(fnlo));
+        fnlo.setMember(i);
+        vector<TH1D*> hMem = readHisto(fnlo);
+        if(i == 0) {
+            hCnt = hMem;
+            acc.assign(hCnt.size(), pdfUncAccumulator(et));
+        }
+        for(int y = 0; y < hMem.size(); ++y) {
+            vector<double> v(hMem[y]->GetNbinsX());
+            for(int j = 0; j < v.size(); ++j)
+                v[j] = hMem[y]->GetBinContent(j+1);
+            acc[y].add(v);
+            if(i > 0) delete hMem[y];
+        }
     }
 
-    vector<TH1D*> hCnt(histos[0].size());
-    vector<TH1D*> hUp(histos[0].size());
-    vector<TH1D*> hDn(histos[0].size());
+    vector<TH1D*> hUp(hCnt.size());
+    vector<TH1D*> hDn(hCnt.size());
 
-    for(int y = 0; y < histos[0].size(); ++y) { //loop over y-bins
+    for(int y = 0; y < hCnt.size(); ++y) { //loop over y-bins
+        hUp[y] = (TH1D*) hCnt[y]->Clone(rn());
+        hDn[y] = (TH1D*) hCnt[y]->Clone(rn());
 
-        hCnt[y] = (TH1D*) histos[0][y]->Clone(rn());
-        hUp[y] = (TH1D*) histos[0][y]->Clone(rn());
-        hDn[y] = (TH1D*) histos[0][y]->Clone(rn());
-
-        for(int i = 1; i <= histos[0][y]->GetNbinsX(); ++i) { //loop over pt-bins
-            double cnt = histos[0][y]->GetBinContent(i);
-            double up = 0, dn = 0;
-            for(int s = 1; s < nPDFs; ++s) { //loop over scales
-                double err  = (histos[s][y]->GetBinContent(i) - cnt)/Fact;
-                up = hypot(up, max(0.0, err));
-                dn = hypot(dn, max(0.0,-err));
-            }
-            hCnt[y]->SetBinContent(i, cnt);
-            hUp[y]->SetBinContent(i, cnt + up);
-            hDn[y]->SetBinContent(i, cnt - dn);
+        vector<double> cnt, up, dn;
+        acc[y].getResult(cnt, up, dn);
+        for(int i = 1; i <= hCnt[y]->GetNbinsX(); ++i) { //loop over pt-bins
+            hUp[y]->SetBinContent(i, cnt[i-1] + up[i-1]);
+            hDn[y]->SetBinContent(i, cnt[i-1] - dn[i-1]);
         }
     }
     return {hCnt, hUp, hDn};
 }
 
-//Get histo using interpolation
-vector<TH1D*> getAsHisto(map<double, fastNLOAlphas*> &fnloMap, double as)
-{
-    fastNLOAlphas *fastL, *fastH;
-    double asL, asH;
-    for(auto fast : fnloMap) {
-        if(fast.first <= as) {
-            asL   = fast.first;
-            fastL = fast.second;
-        }
-        if(fast.first >= as) {
-            asH = fast.first;
-            fastH = fast.second;
-            break;
+//Interpolation of the cross sections in alphaS
+//Each member and scale is calculated once for every alphaS table of the grid,
+//afterwards any alphaS within the grid is obtained from the per-bin cubic splines without fastNLO call
+struct asInterpolator {
+    vector<double> asGrid;
+    int nScl = 0, nMem = 0;
+    vector<TH1D*> hTemp;  //binning, [y]
+    vector<int> yOff;     //first global bin of each rapidity
+    vector<asSpline> spl; //[mem*nScl + scale]
+
+    asInterpolator(map<double, theoryProvider*> &fnloMap, vector<vector<double>> scales = {{1, 1}}, int nMem_ = 1)
+    {
+        nScl = scales.size();
+        nMem = nMem_;
+        vector<vector<double>> vals(nMem*nScl); //[slot][iAs][bin]
+
+        for(auto fast : fnloMap) {
+            asGrid.push_back(fast.first);
+            fast.second->setAlphasMz(fast.first);
+            for(int m = 0; m < nMem; ++m)
+            for(int s = 0; s < nScl; ++s) {
+                fast.second->setMember(m);
+                fast.second->setScaleFactors(scales[s][0], scales[s][1]);
+                auto hh = readHisto(*fast.second);
+                if(hTemp.empty()) {
+                    hTemp = hh;
+                    yOff = {0};
+                    for(auto h : hTemp) yOff.push_back(yOff.back() + h->GetNbinsX());
+                }
+                for(int y = 0; y < hh.size(); ++y) {
+                    for(int i = 1; i <= hh[y]->GetNbinsX(); ++i)
+                        vals[m*nScl + s].push_back(hh[y]->GetBinContent(i));
+                    if(hh[y] != hTemp[y]) delete hh[y];
+                }
+            }
         }
+        for(const auto &v : vals)
+            spl.push_back(asSpline(asGrid, v));
     }
-    auto hL = readHisto(*fastL);
-    auto hH = readHisto(*fastH);
 
-    vector<TH1D*> hAvg(hL.size());
-    for(int y = 0; y < hL.size(); ++y) {
-       hAvg[y] = (TH1D*) hL[y]->Clone(rn());
-       hAvg[y]->Add(hL[y], hH[y],  (asH - as)/(asH-asL), (as - asL)/(asH-asL));
+    //Histograms (one per rapidity) at alphaS as for member mem and scale choice s
+    vector<TH1D*> get(double as, int mem = 0, int s = 0) const
+    {
+        vector<double> v = spl[mem*nScl + s].eval(as);
+        vector<TH1D*> hh(hTemp.size());
+        for(int y = 0; y < hTemp.size(); ++y) {
+            hh[y] = (TH1D*) hTemp[y]->Clone(rn());
+            for(int i = 1; i <= hh[y]->GetNbinsX(); ++i) {
+                hh[y]->SetBinContent(i, v[yOff[y] + i-1]);
+                hh[y]->SetBinError(i, 0);
+            }
+        }
+        return hh;
     }
-    return hAvg;
-}
+};
 
 //Get histogram including up and dn aS variation 
 //input: fastNLO map ideally for 0.116, 0.117, 0.118, 0.119, 0.200
-vector<vector<TH1D*>> getAsHistos(map<double, fastNLOAlphas*> &fnloMap)
+vector<vector<TH1D*>> getAsHistos(map<double, theoryProvider*> &fnloMap)
 {
-    for(auto fast : fnloMap) {
-        fast.second->SetLHAPDFMember(0);
-        fast.second->SetScaleFactorsMuRMuF(1, 1);
-        fast.second->SetAlphasMz(fast.first, true);
-    }
+    asInterpolator asInt(fnloMap);
 
     const double asErr = 0.0015;
-    auto hU =  getAsHisto(fnloMap, 0.1180+asErr);
-    auto hD =  getAsHisto(fnloMap, 0.1180-asErr);
-    auto hC =  readHisto(*fnloMap.at(0.118));
+    auto hU =  asInt.get(0.1180+asErr);
+    auto hD =  asInt.get(0.1180-asErr);
+    auto hC =  asInt.get(0.1180);
 
     vector<TH1D*> hUp(hU.size());
     vector<TH1D*> hDn(hD.size());
@@ -404,31 +384,6 @@ vector<vector<TH1D*>> getAsHistos(map<double, fastNLOAlphas*> &fnloMap)
 
 
 
-//rebin differential histo according to template
-TH1D *rebin(TH1D *h, TH1D *hTemp) //second is template
-{
-    TH1D *hNew = (TH1D *) hTemp->Clone(rn());
-    hNew->Reset();
-
-    for(int i = 1; i <= h->GetNbinsX(); ++i) {
-        double xCnt = h->GetBinCenter(i);
-
-        double iBin = hNew->FindBin(xCnt);
-
-        if(iBin == 0 || iBin == hNew->GetNbinsX()+1)
-            continue;
-
-        double v = h->GetBinContent(i);
-        double w = h->GetBinWidth(i);
-
-        double orgVal = hNew->GetBinContent(iBin);
-        hNew->SetBinContent(iBin, orgVal + v*w);
-    }
-
-    hNew->Scale(1, "width");
-    return hNew;
-}
-
 void printHisto(TH1D *h)
 {
     for(int i = 1; i < h->GetNbinsX(); ++i) {
@@ -458,6 +413,7 @@ void SaveHistosByTitle(vector<vector<TH1D*>> hist)
             TString n = hist[s][y]->GetTitle();
             cout << "Saving to root " << s <<" "<< y <<" : "<<  n << endl;
             hist[s][y]->SetName(n);
+            INSTR_SCOPE("rootWrite");
             hist[s][y]->Write(n);
         }
     }
@@ -465,46 +421,104 @@ void SaveHistosByTitle(vector<vector<TH1D*>> hist)
 
 
 //Create the root file with many theoryes 
-void scanAsToFile(int R)
+//pdf sets of pdfList, the output file is cmsJetsAsScan_ak<R>.root for empty outName
+//With nShards > 1 only the shard iShard of the tasks (getScanTasks) is evaluated, the partial file (getShardName)
+//contains also the list of its tasks, the shards are combined by mergeTheory
+void scanAsToFile(int R, vector<TString> pdfList, TString outName, int iShard, int nShards)
 {
-    vector<TString> pdfList = {"CT14nlo", "CT14nnlo", "HERAPDF20_NLO", "HERAPDF20_NNLO",   "NNPDF31_nlo", "NNPDF31_nnlo", "ABMP16_5_nlo", "ABMP16_5_nnlo"};
     //vector<TString> pdfList = { "ABMP16_5_nlo", "ABMP16_5_nnlo"};
 
+    if(outName == "") outName = Form("cmsJetsAsScan_ak%d.root",R);
+    vector<scanTask> tasks = getScanTasks(pdfList);
+    int first = (long long) tasks.size() * iShard / nShards;
+    int last  = (long long) tasks.size() * (iShard+1) / nShards;
+    if(nShards > 1) {
+        outName = getShardName(outName, iShard, nShards);
+        cout << "Shard " << iShard << " of " << nShards << " : tasks " << first << " - " << last-1 << " of " << tasks.size() << endl;
+    }
+    TFile *fOut = new TFile(outName, "RECREATE");
+
+    vector<vector<TString>> names = runScanTasks(R, tasks, first, last);
+
+    //pdf uncertainty type of the alphaS=0.118 set, used by fitTheory
+    set<TString> pdfDone;
+    for(int t = first; t < last; ++t) {
+        TString pdf = tasks[t].pdf;
+        if(pdfDone.count(pdf)) continue;
+        pdfDone.insert(pdf);
+        TNamed errType(pdf + "_errType", getErrType(getLHAname(pdf, 118)).toString());
+        errType.Write(pdf + "_errType");
+    }
 
-    TFile *fOut = new TFile(Form("cmsJetsAsScan_ak%d.root",R), "RECREATE");
-
-    for(auto pdf : pdfList) {
-        vector<vector<TH1D*>> histPDF    = getAsScaleuncHistos(pdf, R);
-        SaveHistosByTitle(histPDF);
+    //the shard and its tasks, the signature identifies the whole task list (R, theory and the tasks)
+    if(nShards > 1) {
+        TString all = Form("R%d %s", R, useMock ? "mock" : "fastNLO");
+        for(const auto &tk : tasks)
+            all += " " + tk.getTitle(0);
+        TString list;
+        for(int t = first; t < last; ++t) {
+            list += Form("%d %s", t, tasks[t].pdf.Data());
+            for(auto n : names[t-first])
+                list += " " + n;
+            list += "\n";
+        }
+        TNamed shard("scanShard", Form("%d %d %d %016llx", iShard, nShards, int(tasks.size()), (unsigned long long) fnv1a(all)));
+        shard.Write("scanShard");
+        TNamed taskList("scanTasks", list);
+        taskList.Write("scanTasks");
     }
 
+    INSTR_SCOPE("rootWrite");
     fOut->Write();
     fOut->Close();
 }
 
+//FNV-1a hash of the text, stable between the machines
+uint64_t fnv1a(const TString &s)
+{
+    uint64_t h = 1469598103934665603ULL;
+    for(int i = 0; i < s.Length(); ++i) {
+        h ^= (unsigned char) s[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
 
-void setNLO(fastNLOAlphas &fnlo)
+//Partial output of the shard, e.g. cmsJetsAsScan_ak4_shard3of8.root
+TString getShardName(TString outName, int iShard, int nShards)
 {
-    fnlo.SetContributionON(fastNLO::kFixedOrder,0,true);
-    fnlo.SetContributionON(fastNLO::kFixedOrder,1,true);
-    fnlo.SetUnits(fastNLO::kPublicationUnits);
+    TString base = outName.EndsWith(".root") ? TString(outName(0, outName.Length()-5)) : outName;
+    return base + Form("_shard%dof%d.root", iShard, nShards);
+}
+
+//Shard given by the MPI launcher (mpirun of Open MPI, MPICH or srun), the program itself does not use MPI
+bool getMpiShard(int &iShard, int &nShards)
+{
+    const char *vars[][2] = { {"OMPI_COMM_WORLD_RANK", "OMPI_COMM_WORLD_SIZE"}, {"PMI_RANK", "PMI_SIZE"}, {"SLURM_PROCID", "SLURM_NTASKS"} };
+    for(auto v : vars)
+        if(getenv(v[0]) && getenv(v[1])) {
+            iShard  = atoi(getenv(v[0]));
+            nShards = atoi(getenv(v[1]));
+            return true;
+        }
+    return false;
+}
+
+
+void setNLO(theoryProvider &fnlo)
+{
+    fnlo.setNLO();
 }
 
 vector<vector<vector<TH1D*>>> calcXsections(int R, TString pdfName)
 {
 
     using namespace std;
-    using namespace say;		// namespace for 'speaker.h'-verbosity levels
-    using namespace fastNLO;	// namespace for fastNLO constants
 
-
-    TString fastName;
-    if(R == 4)      fastName = "theorFiles/InclusiveNJets_fnl5362h_v23_fix.tab";
-    else if(R == 7) fastName = "theorFiles/InclusiveNJets_fnl5332h_v23_fix.tab";
-    else assert(1);
+    TString fastName = getTableName(R);
 
     cout << "Helenka " << __LINE__ << endl;
-    fastNLOAlphas fnlo(fastName.Data(), getLHAname(pdfName, 118).Data(), 0);
+    theoryProvider &fnlo = *makeProvider(fastName, getLHAname(pdfName, 118));
     cout << "Helenka " << __LINE__ << endl;
     setNLO(fnlo);
     cout << "Helenka " << __LINE__ << endl;
@@ -517,7 +531,7 @@ vector<vector<vector<TH1D*>>> calcXsections(int R, TString pdfName)
     vector<vector<TH1D*>> histAs;
     if(!pdfName.Contains("MMHT2014")) {
 
-        map<double,fastNLOAlphas*> fnloMap;
+        map<double,theoryProvider*> fnloMap;
         //get alphaS unc vector
         vector<TString> names;
 
@@ -527,7 +541,7 @@ vector<vector<vector<TH1D*>>> calcXsections(int R, TString pdfName)
             if(asI < 116 || asI > 120) continue;
             TString pdfNameAs = getLHAname(pdfName, asI);
             cout << fastName.Data() <<" "<< pdfNameAs.Data() << endl;
-            fnloMap.insert( make_pair(asI/1000., new fastNLOAlphas(fastName.Data(), pdfNameAs.Data(), 0)) );
+            fnloMap.insert( make_pair(asI/1000., makeProvider(fastName, pdfNameAs)) );
             setNLO(*fnloMap.at(asI/1000.));
         }
         histAs = getAsHistos(fnloMap);
@@ -575,14 +589,54 @@ int main(int argc, char** argv){
 
   // namespaces
   using namespace std;
+#ifndef NO_FASTNLO
   using namespace say;		// namespace for 'speaker.h'-verbosity levels
   using namespace fastNLO;	// namespace for fastNLO constants
 
 	SetGlobalVerbosity(ERROR);
+#endif
 
-
-    scanAsToFile(4);
-    scanAsToFile(7);
+    //--mock: synthetic theory, e.g. for benchmarks on machines without the tables and pdf sets
+    //--R=4,7 jet radii, --pdf=<set1,set2,..> pdf sets, --out=<file> output (for a single R)
+    //--shard=<i>/<N> evaluates only the shard i (0..N-1) of the tasks, --shard=mpi takes i and N from the MPI launcher
+    vector<int> radii = {4, 7};
+    vector<TString> pdfList = {"CT14nlo", "CT14nnlo", "HERAPDF20_NLO", "HERAPDF20_NNLO",   "NNPDF31_nlo", "NNPDF31_nnlo", "ABMP16_5_nlo", "ABMP16_5_nnlo"};
+    TString outName;
+    int iShard = 0, nShards = 1;
+    for(int i = 1; i < argc; ++i) {
+        TString a = argv[i];
+        TString val = a.Contains('=') ? TString(a(a.First('=')+1, a.Length())) : TString("");
+        if(a == "--mock") useMock = true;
+        else if(a.BeginsWith("--R=")) {
+            radii.clear();
+            for(auto r : splitString(val, ','))
+                radii.push_back(r.Atoi());
+        }
+        else if(a.BeginsWith("--pdf=")) pdfList = splitString(val, ',');
+        else if(a.BeginsWith("--out=")) outName = val;
+        else if(a == "--shard=mpi" && getMpiShard(iShard, nShards)) continue;
+        else if(a.BeginsWith("--shard=") && sscanf(val.Data(), "%d/%d", &iShard, &nShards) == 2) continue;
+        else {
+            cout << "Usage: " << argv[0] << " [--mock] [--R=4,7] [--pdf=CT14nnlo,...] [--out=<file>] [--shard=<i>/<N>|mpi]" << endl;
+            return 1;
+        }
+    }
+    if(nShards < 1 || iShard < 0 || iShard >= nShards) {
+        cout << "Wrong shard " << iShard << " of " << nShards << endl;
+        return 1;
+    }
+    if(outName != "" && radii.size() != 1) {
+        cout << "--out needs a single jet radius" << endl;
+        return 1;
+    }
+#ifdef NO_FASTNLO
+    useMock = true;
+#endif
+    if(useMock)
+        cout << "Mock theory is used instead of fastNLO + LHAPDF" << endl;
+
+    for(int R : radii)
+        scanAsToFile(R, pdfList, outName, iShard, nShards);
     return 0;
 
 
@@ -602,15 +656,10 @@ int main(int argc, char** argv){
 
     //say::SetGlobalVerbosity(say::DEBUG);
 
-    fastNLOAlphas fnloOld("theorFiles/fastnlo-cms-incjets-arxiv-1605.04436-xsec001.tab", "CT14nlo", 0);
-    fastNLOAlphas fnloNew("theorFiles/InclusiveNJets_fnl5362h_v23_fix.tab", "CT14nlo", 0);
-    fnloOld.SetContributionON(fastNLO::kFixedOrder,0,true);
-    fnloOld.SetContributionON(fastNLO::kFixedOrder,1,true);
-    fnloOld.SetUnits(fastNLO::kPublicationUnits);
-
-    fnloNew.SetContributionON(fastNLO::kFixedOrder,0,true);
-    fnloNew.SetContributionON(fastNLO::kFixedOrder,1,true);
-    fnloNew.SetUnits(fastNLO::kPublicationUnits);
+    theoryProvider &fnloOld = *makeProvider("theorFiles/fastnlo-cms-incjets-arxiv-1605.04436-xsec001.tab", "CT14nlo");
+    theoryProvider &fnloNew = *makeProvider("theorFiles/InclusiveNJets_fnl5362h_v23_fix.tab", "CT14nlo");
+    setNLO(fnloOld);
+    setNLO(fnloNew);
 
 
 
@@ -633,7 +682,7 @@ int main(int argc, char** argv){
     /*
     return 0;
 
-    int nMem = fnloOld.GetNPDFMembers();
+    int nMem = fnloOld.getNmembers();
 
 
     vector<TH1D*> oldH = readHisto(fnloOld);
@@ -22,6 +22,7 @@
 #include "TLine.h"
 
 #include "plottingHelper.h"
+#include "rebin.h" //libAsFitter.so
 using namespace PlottingHelper;
 
 
@@ -81,29 +82,6 @@ vector<TH1D*> readHisto(fastNLOLHAPDF &fnlo)
 
 }
 
-TH1D *rebin(TH1D *h, TH1D *hTemp) //second is template
-{
-    TH1D *hNew = (TH1D *) hTemp->Clone(rn());
-    hNew->Reset();
-
-    for(int i = 1; i <= h->GetNbinsX(); ++i) {
-        double xCnt = h->GetBinCenter(i);
-
-        double iBin = hNew->FindBin(xCnt);
-
-        if(iBin == 0 || iBin == hNew->GetNbinsX()+1)
-            continue;
-
-        double v = h->GetBinContent(i);
-        double w = h->GetBinWidth(i);
-
-        double orgVal = hNew->GetBinContent(iBin);
-        hNew->SetBinContent(iBin, orgVal + v*w);
-    }
-
-    hNew->Scale(1, "width");
-    return hNew;
-}
 
 void printHisto(TH1D *h)
 {
@@ -0,0 +1,61 @@
+//Query of the chi2 scan table written by fitTheory
+//  ./chi2Query chi2Anal/chi2scan.root pdf=CT14nnlo order=nnlo unc=0 y=-1 pt=-1 scale=0 var=Hall [points]
+//Every selected scan is printed with the fitted alphaS minimum, omitted keys mean any value
+#include <iostream>
+#include <iomanip>
+
+#include "chi2Scan.h"
+
+using namespace std;
+
+int main(int argc, char** argv)
+{
+    if(argc < 2) {
+        cout << "Usage: " << argv[0] << " <chi2scan.root> [pdf=..] [order=..] [unc=..] [y=..] [pt=..] [scale=..] [var=..] [points]" << endl;
+        return 1;
+    }
+
+    chi2Query q;
+    bool printPoints = false;
+    for(int i = 2; i < argc; ++i) {
+        TString a = argv[i];
+        if(a == "points") { printPoints = true; continue; }
+        int eq = a.First('=');
+        if(eq < 0) {
+            cout << "Wrong selection " << a << endl;
+            return 1;
+        }
+        TString key = a(0, eq);
+        TString val = a(eq+1, a.Length());
+        if(key == "pdf")        q.pdf     = val;
+        else if(key == "order") q.order   = val;
+        else if(key == "var")   q.variant = val;
+        else if(key == "unc")   q.unCorr  = val.Atof();
+        else if(key == "y")     q.y       = val.Atoi();
+        else if(key == "pt")    q.pt      = val.Atoi();
+        else if(key == "scale") q.scale   = val.Atoi();
+        else {
+            cout << "Unknown key " << key << endl;
+            return 1;
+        }
+    }
+
+    chi2ScanTable tab;
+    tab.load(argv[1]);
+
+    cout << "pdf order unc y pt scale variant ndf asMin errDn errUp chi2Min" << endl;
+    auto grp = tab.groups(q);
+    std::vector<chi2Min> mins = tab.getMinima(grp);
+    int iG = 0;
+    for(const auto &g : grp) {
+        const auto &r = tab.rows[g.second[0]];
+        const chi2Min &m = mins[iG++];
+        cout << r.pdf <<" "<< r.order <<" "<< r.unCorr <<" "<< r.y <<" "<< r.pt <<" "<< r.scale <<" "<< r.variant <<" "<< r.ndf <<" "
+             << setprecision(5) << m.asMin <<" "<< m.errDn <<" "<< m.errUp <<" "<< m.chi2Min << endl;
+        if(printPoints)
+            for(int i : g.second)
+                cout << "   " << tab.rows[i].alphaS << " " << tab.rows[i].chi2 << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,213 @@
+#ifndef chi2Scan_H
+#define chi2Scan_H
+
+#include <vector>
+#include <map>
+#include <tuple>
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+
+#include "TString.h"
+#include "TFile.h"
+#include "TTree.h"
+#include "TGraph.h"
+#include "TF1.h"
+
+#include "asExtract.h"
+
+//Columnar table of the chi2 scans, one row per (pdf, order, unCorr, y, pt, scale, alphaS, variant)
+//  y, pt   : rapidity and pt bin of the selection, -1 for all
+//  variant : Hall, HnoNP, HnoPDF (HERA chi2), Sall (simple), Nall (naive)
+//The table is stored as the TTree "chi2scan", i.e. the columns are read at once instead of a TKey per graph
+
+struct chi2Row {
+    TString pdf, order, variant;
+    double unCorr;
+    int y, pt, scale;
+    double alphaS, chi2;
+    int ndf;
+};
+
+struct chi2ScanWriter {
+    TFile *f = nullptr;
+    TTree *t = nullptr;
+    char pdf[32], order[16], variant[16];
+    double unCorr, alphaS, chi2;
+    int y, pt, scale, ndf;
+
+    chi2ScanWriter(TString fName)
+    {
+        f = TFile::Open(fName, "RECREATE");
+        if(!f) {
+            std::cout << "Cannot create " << fName << std::endl;
+            exit(1);
+        }
+        t = new TTree("chi2scan", "chi2 scans");
+        t->Branch("pdf",     pdf,     "pdf/C");
+        t->Branch("order",   order,   "order/C");
+        t->Branch("unCorr",  &unCorr, "unCorr/D");
+        t->Branch("y",       &y,      "y/I");
+        t->Branch("pt",      &pt,     "pt/I");
+        t->Branch("scale",   &scale,  "scale/I");
+        t->Branch("alphaS",  &alphaS, "alphaS/D");
+        t->Branch("variant", variant, "variant/C");
+        t->Branch("chi2",    &chi2,   "chi2/D");
+        t->Branch("ndf",     &ndf,    "ndf/I");
+    }
+
+    //Add all points of the graph (x = alphaS, y = chi2)
+    void fill(TString pdfN, TString orderN, double unc, int yN, int ptN, int sN, TString var, int ndfN, TGraph *gr)
+    {
+        strncpy(pdf,     pdfN.Data(),   sizeof(pdf)-1);     pdf[sizeof(pdf)-1] = 0;
+        strncpy(order,   orderN.Data(), sizeof(order)-1);   order[sizeof(order)-1] = 0;
+        strncpy(variant, var.Data(),    sizeof(variant)-1); variant[sizeof(variant)-1] = 0;
+        unCorr = unc;
+        y = yN; pt = ptN; scale = sN;
+        ndf = ndfN;
+        for(int i = 0; i < gr->GetN(); ++i) {
+            alphaS = gr->GetX()[i];
+            chi2   = gr->GetY()[i];
+            t->Fill();
+        }
+    }
+
+    void close()
+    {
+        f->cd();
+        t->Write();
+        f->Close();
+    }
+};
+
+
+//Selection of the rows, empty strings and values < -1 (for ints) or < 0 (for unCorr) mean any
+struct chi2Query {
+    TString pdf, order, variant;
+    double unCorr = -1;
+    int y = -2, pt = -2, scale = -2;
+
+    bool match(const chi2Row &r) const
+    {
+        if(pdf != ""     && r.pdf != pdf)         return false;
+        if(order != ""   && r.order != order)     return false;
+        if(variant != "" && r.variant != variant) return false;
+        if(unCorr >= 0   && std::abs(r.unCorr - unCorr) > 1e-6) return false;
+        if(y >= -1       && r.y != y)             return false;
+        if(pt >= -1      && r.pt != pt)           return false;
+        if(scale >= -1   && r.scale != scale)     return false;
+        return true;
+    }
+};
+
+
+//Minimum of the chi2 parabola-like curve in alphaS
+struct chi2Min {
+    double asMin, chi2Min, errUp, errDn;
+};
+
+struct chi2ScanTable {
+    std::vector<chi2Row> rows;
+
+    void load(TString fName)
+    {
+        TFile *f = TFile::Open(fName);
+        TTree *t = f ? (TTree*) f->Get("chi2scan") : nullptr;
+        if(!t) {
+            std::cout << "Cannot read chi2scan from " << fName << std::endl;
+            exit(1);
+        }
+        char pdf[32], order[16], variant[16];
+        double unCorr, alphaS, chi2;
+        int y, pt, scale, ndf;
+        t->SetBranchAddress("pdf",     pdf);
+        t->SetBranchAddress("order",   order);
+        t->SetBranchAddress("unCorr",  &unCorr);
+        t->SetBranchAddress("y",       &y);
+        t->SetBranchAddress("pt",      &pt);
+        t->SetBranchAddress("scale",   &scale);
+        t->SetBranchAddress("alphaS",  &alphaS);
+        t->SetBranchAddress("variant", variant);
+        t->SetBranchAddress("chi2",    &chi2);
+        t->SetBranchAddress("ndf",     &ndf);
+
+        rows.reserve(rows.size() + t->GetEntries());
+        for(Long64_t i = 0; i < t->GetEntries(); ++i) {
+            t->GetEntry(i);
+            rows.push_back({pdf, order, variant, unCorr, y, pt, scale, alphaS, chi2, ndf});
+        }
+        f->Close();
+    }
+
+    //Indexes of the selected rows
+    std::vector<int> select(const chi2Query &q) const
+    {
+        std::vector<int> idx;
+        for(int i = 0; i < rows.size(); ++i)
+            if(q.match(rows[i])) idx.push_back(i);
+        return idx;
+    }
+
+    //Selected rows grouped to the scans (one graph in alphaS for each pdf, order, unCorr, y, pt, scale, variant)
+    std::map<std::tuple<TString,TString,double,int,int,int,TString>, std::vector<int>> groups(const chi2Query &q) const
+    {
+        std::map<std::tuple<TString,TString,double,int,int,int,TString>, std::vector<int>> grp;
+        for(int i : select(q)) {
+            const auto &r = rows[i];
+            grp[std::make_tuple(r.pdf, r.order, r.unCorr, r.y, r.pt, r.scale, r.variant)].push_back(i);
+        }
+        return grp;
+    }
+
+    TGraph *getGraph(const std::vector<int> &idx) const
+    {
+        TGraph *gr = new TGraph(idx.size());
+        for(int i = 0; i < idx.size(); ++i)
+            gr->SetPoint(i, rows[idx[i]].alphaS, rows[idx[i]].chi2);
+        return gr;
+    }
+
+    void getPoints(const std::vector<int> &idx, std::vector<double> &x, std::vector<double> &y) const
+    {
+        x.resize(idx.size());
+        y.resize(idx.size());
+        for(int i = 0; i < idx.size(); ++i) {
+            x[i] = rows[idx[i]].alphaS;
+            y[i] = rows[idx[i]].chi2;
+        }
+    }
+
+    static chi2Min toMin(const asFitResult &r)
+    {
+        return {r.asMin, r.chi2Min, r.errUp, r.errDn};
+    }
+
+    //alphaS at the minimum of the pol4 fit and the dChi2 = 1 crossings
+    chi2Min getMinimum(const std::vector<int> &idx) const
+    {
+        std::vector<double> x, y;
+        getPoints(idx, x, y);
+        return toMin(fitAsPol4(x, y));
+    }
+
+    //Minima of all the groups at once, the fits run in parallel
+    template<typename Groups>
+    std::vector<chi2Min> getMinima(const Groups &grp, int nThreads = 0) const
+    {
+        std::vector<std::vector<double>> xs(grp.size()), ys(grp.size());
+        int i = 0;
+        for(const auto &g : grp) {
+            getPoints(g.second, xs[i], ys[i]);
+            ++i;
+        }
+        std::vector<chi2Min> res;
+        for(const auto &r : fitAsBatch(xs, ys, nThreads))
+            res.push_back(toMin(r));
+        return res;
+    }
+};
+
+
+#endif
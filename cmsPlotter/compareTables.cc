@@ -0,0 +1,442 @@
+//Batch comparison of fastNLO tables, every table with every pdf set and scale choice relative to the reference table
+//  ./compareTables --tables=<t0>,<t1>,... [--pdf=CT14nlo,...] [--scales=0] [--as=0.118] [--ref=0] [--tol=0.001]
+//                  [--ptMin=0] [--ptMax=1e9] [--binning=common|ref] [--jobs=4] [--out=tableCheck.json] [--plots=<file.pdf>] [--mock]
+//Each table is parsed once, the worker processes (fork) share the parsed tables and evaluate contiguous ranges
+//of the (table, pdf, scale) tasks, the cross sections come back through shared memory
+//The tables are compared on a common binning of each rapidity bin (rebin.h):
+//  common  edges present in all tables, the bins are only merged
+//  ref     bins of the reference table, partly overlapping bins of the other tables are split proportionally
+//The JSON report contains the ratios to the reference and the maximal deviation of every (table, pdf, scale, y),
+//the exit code is 2 if any deviation exceeds tol
+#include <iostream>
+#include <vector>
+#include <map>
+#include <set>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "TH1D.h"
+#include "TCanvas.h"
+#include "TStyle.h"
+#include "TLine.h"
+
+#include "plottingHelper.h"
+#include "theoryProvider.h"
+#include "tools.h"
+#include "rebin.h" //libAsFitter.so
+using namespace PlottingHelper;
+
+using namespace std;
+
+struct compareTask {
+    int table, pdf, scale;
+};
+
+//Binning of the table in one rapidity bin, the provider bins idx are ordered in pt
+struct tableBins {
+    vector<int> idx;
+    vector<double> edges;
+};
+
+//Comparison of one (table, pdf, scale) with the reference in the rapidity bin y
+struct compareResult {
+    int task;
+    TString y;
+    vector<double> edges, ratio;
+    double maxDev = 0, ptMaxDev = 0;
+    int nFail = 0;
+};
+
+struct tableComparer {
+    vector<TString> tables, pdfs;
+    vector<int> scales = {0};
+    double as = 0.118, tol = 1e-3, ptMin = 0, ptMax = 1e9;
+    int ref = 0, nJobs = 1;
+    TString binning = "common";
+    bool mock = false;
+
+    vector<theoryProvider*> provs;           //one parsed table each
+    vector<map<TString, tableBins>> bins;    //[table][|y| low edge]
+    vector<compareTask> tasks;
+    vector<size_t> offset;                   //of the task cross sections in xsBuf
+    vector<pair<TString, TString>> skipped;  //rapidity bins which could not be compared and why
+    double *xsBuf = nullptr;                 //shared with the workers
+    char *done = nullptr;                    //task finished, shared with the workers
+
+    //Parse the tables (before the fork, so the workers share them)
+    void load()
+    {
+        for(auto t : tables) {
+            cout << "Reading " << t << endl;
+            theoryProvider *p;
+#ifndef NO_FASTNLO
+            if(!mock)
+                p = new fastNLOProvider(t, pdfs[0]);
+            else
+#endif
+                p = new mockProvider(t, pdfs[0]);
+            p->setNLO();
+            provs.push_back(p);
+
+            map<TString, tableBins> b;
+            for(int k = 0; k < p->getNbins(); ++k) {
+                tableBins &tb = b[Form("%g", p->getBinLo(k,0))];
+                tb.idx.push_back(k);
+                if(tb.edges.empty()) tb.edges.push_back(p->getBinLo(k,1));
+                tb.edges.push_back(p->getBinUp(k,1));
+            }
+            bins.push_back(b);
+        }
+
+        size_t n = 0;
+        for(int t = 0; t < tables.size(); ++t)
+            for(int p = 0; p < pdfs.size(); ++p)
+                for(int s : scales) {
+                    tasks.push_back({t, p, s});
+                    offset.push_back(n);
+                    n += provs[t]->getNbins();
+                }
+        xsBuf = (double*) mmap(nullptr, n*sizeof(double), PROT_READ|PROT_WRITE, MAP_SHARED|MAP_ANONYMOUS, -1, 0);
+        done  = (char*)   mmap(nullptr, tasks.size(), PROT_READ|PROT_WRITE, MAP_SHARED|MAP_ANONYMOUS, -1, 0);
+        if(xsBuf == MAP_FAILED || done == MAP_FAILED) {
+            cout << "Shared memory for " << n << " cross sections not available" << endl;
+            exit(1);
+        }
+    }
+
+    //The provider changes the pdf set only when the next task needs another one
+    void runTasks(int first, int last)
+    {
+        vector<int> pdfNow(tables.size(), 0);
+        for(int i = first; i < last; ++i) {
+            const compareTask &tk = tasks[i];
+            theoryProvider &p = *provs[tk.table];
+            if(pdfNow[tk.table] != tk.pdf) {
+                p.setPdfSet(pdfs[tk.pdf]);
+                pdfNow[tk.table] = tk.pdf;
+            }
+            p.setMember(0);
+            p.setAlphasMz(as);
+            p.setScaleFactors(scaleChoices[tk.scale][0], scaleChoices[tk.scale][1]);
+            vector<double> xs = p.calcCrossSection();
+            copy(xs.begin(), xs.end(), xsBuf + offset[i]);
+            done[i] = 1;
+        }
+    }
+
+    void evaluate()
+    {
+        int nW = max(1, min<int>(nJobs, tasks.size()));
+        if(nW == 1) {
+            runTasks(0, tasks.size());
+            return;
+        }
+        vector<pid_t> pids;
+        for(int w = 0; w < nW; ++w) {
+            int first = (long long) tasks.size() * w / nW;
+            int last  = (long long) tasks.size() * (w+1) / nW;
+            pid_t pid = fork();
+            if(pid == 0) {
+                runTasks(first, last);
+                _exit(0);
+            }
+            if(pid < 0) {
+                cout << "Worker " << w << " not started" << endl;
+                exit(1);
+            }
+            pids.push_back(pid);
+        }
+        bool ok = true;
+        for(auto pid : pids) {
+            int st;
+            waitpid(pid, &st, 0);
+            ok = ok && WIFEXITED(st) && WEXITSTATUS(st) == 0;
+        }
+        for(int i = 0; i < tasks.size(); ++i)
+            ok = ok && done[i];
+        if(!ok) {
+            cout << "Some of the workers failed" << endl;
+            exit(1);
+        }
+    }
+
+    //Common pt edges of the rapidity bin y (inside the range covered by all tables and [ptMin, ptMax])
+    vector<double> getCommonEdges(TString y)
+    {
+        auto has = [](const vector<double> &e, double x) {
+            for(double v : e)
+                if(abs(v - x) < 1e-6 * max(1., abs(x))) return true;
+            return false;
+        };
+        double lo = ptMin, hi = ptMax;
+        for(const auto &b : bins) {
+            lo = max(lo, b.at(y).edges.front());
+            hi = min(hi, b.at(y).edges.back());
+        }
+        const vector<double> &eRef = bins[ref].at(y).edges;
+        vector<double> edges;
+        if(binning == "ref") {
+            edges.push_back(lo);
+            for(double e : eRef)
+                if(e > lo + 1e-6 && e < hi - 1e-6)
+                    edges.push_back(e);
+            edges.push_back(hi);
+        }
+        else {
+            for(double e : eRef) {
+                if(e < lo - 1e-6 || e > hi + 1e-6) continue;
+                bool inAll = true;
+                for(const auto &b : bins)
+                    inAll = inAll && has(b.at(y).edges, e);
+                if(inAll) edges.push_back(e);
+            }
+        }
+        if(edges.size() < 2 || edges.back() <= edges.front()) edges.clear();
+        return edges;
+    }
+
+    vector<compareResult> compare()
+    {
+        //rapidity bins present in all tables, the others are recorded as skipped
+        set<TString> yAll;
+        for(const auto &bt : bins)
+            for(const auto &b : bt)
+                yAll.insert(b.first);
+        vector<TString> ys;
+        skipped.clear();
+        for(auto y : yAll) {
+            TString missing;
+            for(int t = 0; t < bins.size(); ++t)
+                if(!bins[t].count(y)) missing += (missing == "" ? "" : ", ") + tables[t];
+            if(missing == "") ys.push_back(y);
+            else skipped.push_back({y, "not in " + missing});
+        }
+
+        vector<compareResult> res;
+        for(auto y : ys) {
+            vector<double> edges = getCommonEdges(y);
+            if(edges.empty()) {
+                skipped.push_back({y, "no common pt bins"});
+                continue;
+            }
+            //one overlap matrix per table, shared by all pdfs and scales
+            vector<rebinMatrix> mats;
+            for(const auto &b : bins)
+                mats.push_back(rebinMatrix(b.at(y).edges, edges));
+
+            auto getXs = [&](int i) {
+                const tableBins &tb = bins[tasks[i].table].at(y);
+                vector<double> x;
+                for(int k : tb.idx)
+                    x.push_back(xsBuf[offset[i] + k]);
+                return mats[tasks[i].table].apply(x);
+            };
+
+            for(int i = 0; i < tasks.size(); ++i) {
+                if(tasks[i].table == ref) continue;
+                int iRef = i - (tasks[i].table - ref) * pdfs.size() * scales.size(); //same pdf and scale
+                vector<double> x = getXs(i), xRef = getXs(iRef);
+
+                compareResult r;
+                r.task = i;
+                r.y = y;
+                r.edges = edges;
+                for(int j = 0; j < x.size(); ++j) {
+                    double rat = xRef[j] != 0 ? x[j] / xRef[j] : 0;
+                    r.ratio.push_back(rat);
+                    double dev = abs(rat - 1);
+                    if(dev > r.maxDev) {
+                        r.maxDev = dev;
+                        r.ptMaxDev = edges[j];
+                    }
+                    if(dev > tol) ++r.nFail;
+                }
+                res.push_back(r);
+            }
+        }
+        for(const auto &sk : skipped)
+            cout << "Rapidity bin " << sk.first << " skipped, " << sk.second << endl;
+        return res;
+    }
+
+    //All requested comparisons made and within the tolerance
+    bool isOk(const vector<compareResult> &res) const
+    {
+        bool ok = !res.empty() && skipped.empty();
+        for(const auto &r : res)
+            ok = ok && r.nFail == 0;
+        return ok;
+    }
+
+    void writeReport(const vector<compareResult> &res, TString outName)
+    {
+        auto list = [](const vector<TString> &v) {
+            stringstream s;
+            for(int i = 0; i < v.size(); ++i)
+                s << (i ? ", " : "") << "\"" << v[i] << "\"";
+            return s.str();
+        };
+        bool ok = isOk(res);
+
+        ofstream js(outName.Data());
+        js << setprecision(8);
+        js << "{\"ok\": " << (ok ? "true" : "false") << ", \"tol\": " << tol << ", \"binning\": \"" << binning << "\", \"as\": " << as
+           << ",\n \"reference\": \"" << tables[ref] << "\", \"tables\": [" << list(tables) << "], \"pdfs\": [" << list(pdfs) << "],\n \"results\": [";
+        for(int k = 0; k < res.size(); ++k) {
+            const compareResult &r = res[k];
+            const compareTask &tk = tasks[r.task];
+            js << (k ? ",\n" : "\n") << "  {\"table\": \"" << tables[tk.table] << "\", \"pdf\": \"" << pdfs[tk.pdf] << "\", \"scale\": " << tk.scale
+               << ", \"y\": " << r.y << ", \"ok\": " << (r.nFail ? "false" : "true") << ", \"nFail\": " << r.nFail
+               << ", \"maxDev\": " << r.maxDev << ", \"ptMaxDev\": " << r.ptMaxDev << ", \"edges\": [";
+            for(int j = 0; j < r.edges.size(); ++j) js << (j ? ", " : "") << r.edges[j];
+            js << "], \"ratio\": [";
+            for(int j = 0; j < r.ratio.size(); ++j) js << (j ? ", " : "") << r.ratio[j];
+            js << "]}";
+        }
+        js << "\n ],\n \"skipped\": [";
+        for(int k = 0; k < skipped.size(); ++k)
+            js << (k ? ",\n" : "\n") << "  {\"y\": " << skipped[k].first << ", \"reason\": \"" << skipped[k].second << "\"}";
+        js << "\n ]}" << endl;
+        cout << "Report written to " << outName << endl;
+    }
+
+    //One page per (table, pdf, scale), the ratio to the reference in all rapidity bins
+    void plot(const vector<compareResult> &res, TString plotName)
+    {
+        map<int, vector<const compareResult*>> pages;
+        for(const auto &r : res)
+            pages[r.task].push_back(&r);
+
+        gStyle->SetOptStat(0);
+        int iPage = 0;
+        for(const auto &pg : pages) {
+            const compareTask &tk = tasks[pg.first];
+            TCanvas *can = new TCanvas(Form("%d",rand()), "", 1000, 350);
+            SetLeftRight(0.07, 0.03);
+            SetTopBottom(0.05, 0.13);
+            DividePad(vector<double>(pg.second.size(), 1.), {1});
+            for(int k = 0; k < pg.second.size(); ++k) {
+                const compareResult &r = *pg.second[k];
+                TH1D *h = new TH1D(Form("%d",rand()), "", r.edges.size()-1, r.edges.data());
+                for(int j = 0; j < r.ratio.size(); ++j)
+                    h->SetBinContent(j+1, r.ratio[j]);
+
+                can->cd(k+1);
+                gPad->SetLogx();
+                h->Draw("][");
+                GetYaxis()->SetRangeUser(1 - 5*tol, 1 + 5*tol);
+                GetFrame()->SetTitle("");
+                if(k == pg.second.size()-1)
+                    GetXaxis()->SetTitle("Jet p_{T} (GeV)");
+                if(k == 0)
+                    GetYaxis()->SetTitle("#sigma / #sigma^{ref}");
+                GetXaxis()->SetNoExponent();
+                GetXaxis()->SetMoreLogLabels();
+                SetFTO({16}, {10}, {1.25, 2.3, 0.3, 4.2});
+
+                TLegend *leg = newLegend(kPos8c);
+                leg->AddEntry((TObject*)nullptr, r.y + " < |y|", "h");
+                if(k == 0) {
+                    TString tab = tables[tk.table];
+                    leg->AddEntry((TObject*)nullptr, pdfs[tk.pdf] + Form(", scale %d", tk.scale), "h");
+                    leg->AddEntry(h, tab(tab.Last('/')+1, tab.Length()), "l");
+                }
+                DrawLegends({leg}, false);
+
+                TLine *line = new TLine;
+                line->SetLineStyle(2);
+                line->DrawLine(r.edges.front(), 1 + tol, r.edges.back(), 1 + tol);
+                line->DrawLine(r.edges.front(), 1 - tol, r.edges.back(), 1 - tol);
+            }
+            TString opt = pages.size() == 1 ? "" : iPage == 0 ? "(" : iPage == pages.size()-1 ? ")" : "";
+            can->SaveAs(plotName + opt);
+            ++iPage;
+        }
+    }
+};
+
+
+int main(int argc, char** argv)
+{
+#ifndef NO_FASTNLO
+    say::SetGlobalVerbosity(say::ERROR);
+#endif
+
+    tableComparer cmp;
+    cmp.pdfs = {"CT14nlo"};
+    TString outName = "tableCheck.json", plotName;
+    for(int i = 1; i < argc; ++i) {
+        TString a = argv[i];
+        TString val = a.Contains('=') ? TString(a(a.First('=')+1, a.Length())) : TString("");
+        if(a == "--mock") cmp.mock = true;
+        else if(a.BeginsWith("--tables=")) cmp.tables = splitString(val, ',');
+        else if(a.BeginsWith("--pdf="))    cmp.pdfs = splitString(val, ',');
+        else if(a.BeginsWith("--scales=")) {
+            cmp.scales.clear();
+            for(auto s : splitString(val, ','))
+                cmp.scales.push_back(s.Atoi());
+        }
+        else if(a.BeginsWith("--as="))      cmp.as = val.Atof();
+        else if(a.BeginsWith("--ref="))     cmp.ref = val.Atoi();
+        else if(a.BeginsWith("--tol="))     cmp.tol = val.Atof();
+        else if(a.BeginsWith("--ptMin="))   cmp.ptMin = val.Atof();
+        else if(a.BeginsWith("--ptMax="))   cmp.ptMax = val.Atof();
+        else if(a.BeginsWith("--binning=")) cmp.binning = val;
+        else if(a.BeginsWith("--jobs="))    cmp.nJobs = val.Atoi();
+        else if(a.BeginsWith("--out="))     outName = val;
+        else if(a.BeginsWith("--plots="))   plotName = val;
+        else {
+            cout << "Usage: " << argv[0] << " --tables=<t0>,<t1>,... [--pdf=CT14nlo,...] [--scales=0,1,..] [--as=0.118] [--ref=0] [--tol=0.001]" << endl;
+            cout << "       [--ptMin=0] [--ptMax=1e9] [--binning=common|ref] [--jobs=4] [--out=tableCheck.json] [--plots=<file.pdf>] [--mock]" << endl;
+            return 1;
+        }
+    }
+    if(cmp.tables.size() < 2 || cmp.pdfs.empty() || cmp.ref < 0 || cmp.ref >= cmp.tables.size()) {
+        cout << "At least two tables, one pdf set and the reference table index 0.." << int(cmp.tables.size())-1 << " are needed" << endl;
+        return 1;
+    }
+    for(int s : cmp.scales)
+        if(s < 0 || s >= 7) {
+            cout << "Scale choice " << s << " is not in 0..6" << endl;
+            return 1;
+        }
+    if(cmp.binning != "common" && cmp.binning != "ref") {
+        cout << "Unknown binning " << cmp.binning << ", use common or ref" << endl;
+        return 1;
+    }
+#ifdef NO_FASTNLO
+    cmp.mock = true;
+#endif
+
+    cmp.load();
+    cmp.evaluate();
+    vector<compareResult> res = cmp.compare();
+    cmp.writeReport(res, outName);
+    if(plotName != "")
+        cmp.plot(res, plotName);
+
+    //summary, worst rapidity bin of each (table, pdf, scale)
+    map<int, const compareResult*> worst;
+    for(const auto &r : res)
+        if(!worst.count(r.task) || r.maxDev > worst.at(r.task)->maxDev)
+            worst[r.task] = &r;
+    for(const auto &w : worst) {
+        const compareTask &tk = cmp.tasks[w.first];
+        const compareResult &r = *w.second;
+        cout << setw(50) << cmp.tables[tk.table] << " " << setw(20) << cmp.pdfs[tk.pdf] << " scale " << tk.scale
+             << " : max |ratio-1| = " << r.maxDev << " at |y| from " << r.y << ", pt = " << r.ptMaxDev << (r.maxDev > cmp.tol ? "  FAIL" : "") << endl;
+    }
+    if(res.empty())
+        cout << "Nothing compared" << endl;
+    if(!cmp.skipped.empty())
+        cout << cmp.skipped.size() << " rapidity bins not compared" << endl;
+    return cmp.isOk(res) ? 0 : 2;
+}
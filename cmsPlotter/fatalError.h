@@ -0,0 +1,27 @@
+#ifndef fatalError_H
+#define fatalError_H
+
+#include <iostream>
+#include <string>
+#include <stdexcept>
+#include <cstdlib>
+
+//Fatal errors of the theory and fit code: the message is printed and the program exits with 1,
+//or, if throwOnError() is set (fitServer), std::runtime_error is thrown so that the caller can recover
+inline bool &throwOnError()
+{
+    static bool thr = false;
+    return thr;
+}
+
+[[noreturn]] inline void fatalError(const std::string &msg)
+{
+    if(throwOnError()) throw std::runtime_error(msg);
+    std::cout << msg << std::endl;
+    exit(1);
+}
+
+//For TString messages (converted through const char*)
+[[noreturn]] inline void fatalError(const char *msg) { fatalError(std::string(msg)); }
+
+#endif
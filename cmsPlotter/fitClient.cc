@@ -0,0 +1,53 @@
+//Client of fitServer, sends the query given as arguments (or the lines of stdin) and prints the answers
+//  ./fitClient [--socket=fitServer.sock] pdf=CT14nnlo as=0.117 yMax=1 ptMin=500 chi2=hera
+//  ./fitClient < queries.txt
+#include <iostream>
+#include <string>
+
+#include "fitSocket.h"
+
+using namespace std;
+
+int main(int argc, char** argv)
+{
+    string sockName = "fitServer.sock";
+    string query;
+    for(int i = 1; i < argc; ++i) {
+        string a = argv[i];
+        if(a.rfind("--socket=", 0) == 0) sockName = a.substr(9);
+        else if(a.rfind("--", 0) == 0) {
+            cout << "Usage: " << argv[0] << " [--socket=fitServer.sock] [key=value ...]" << endl;
+            return 1;
+        }
+        else query += (query.empty() ? "" : " ") + a;
+    }
+
+    int fd = connectUnix(sockName);
+    if(fd < 0) {
+        cout << "No fit server at " << sockName << endl;
+        return 1;
+    }
+    lineReader rd(fd);
+
+    auto ask = [&](const string &q) {
+        string ans;
+        if(!writeLine(fd, q) || !rd.getLine(ans)) {
+            cout << "Connection to the fit server lost" << endl;
+            exit(1);
+        }
+        cout << ans << endl;
+        return ans.find("\"ok\": true") != string::npos;
+    };
+
+    bool ok = true;
+    if(!query.empty())
+        ok = ask(query);
+    else {
+        string line;
+        while(getline(cin, line))
+            if(line.find_first_not_of(" \t") != string::npos)
+                ok = ask(line) && ok;
+    }
+    close(fd);
+    return ok ? 0 : 2;
+}
@@ -0,0 +1,236 @@
+//Resident fit server, the data and the theory are loaded once and the chi2 queries come over a Unix-domain socket
+//  ./fitServer [--socket=fitServer.sock] [--theory=cmsJetsAsScan_ak4.root] [--data=xFitterTables/table_16ak4_uncorr0.txt] [--order=nnlo] [--shm=<key>]
+//Query, one line of key=value words (only pdf is required):
+//  pdf=CT14nnlo as=0.117|scan scale=0 order=nnlo unc=-1 yMin=0 yMax=2 ptMin=95 ptMax=1e9 chi2=hera,simple dec=default
+//    as=scan     all alphaS values of the scan, the answer contains also the fitted minimum for each chi2 variant
+//    unc         uncorrelated error in %, -1 for the table values
+//    y, pt       bins with yMin <= |y| and |y| <= yMax, ptMin <= pt and pt <= ptMax are used
+//    chi2        simple, hera, heraNoNP, heraNoPDF, naive, cov
+//    dec         default (as fitTheory), none or <source>:<group of y0>,..,<group of y3>;<source>:...
+//The theory of a pdf set is read at its first query. The answer is one line of JSON, {"ok": false, "error": ...} for a wrong query
+//Other commands: ping, shutdown
+#include "asFitter.h" //libAsFitter.so
+#include "fitSocket.h"
+
+#include <chrono>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+
+struct fitServer {
+    asFitter fit;
+    vector<point> data0;     //data before the decorrelation
+    vector<TString> names0;  //sources before the decorrelation
+    TString decNow = "-";    //decorrelation of fit.data
+    TString orderDef, shmKey;
+
+    fitServer(TString dataFile, TString thSpec, TString order, TString shm) : orderDef(order), shmKey(shm)
+    {
+        fit.order = order;
+        fit.setTheory("16ak4", thSpec);
+        data0  = asFitter::readData(dataFile);
+        names0 = ErrNamesTable;
+        setDecorrelation("default");
+        throwOnError() = true; //a failed query is answered with the error, the server keeps running
+    }
+
+    //Theory of pdf read at its first query, a partly read theory is dropped again
+    void loadTheory(TString pdf)
+    {
+        if(fit.thStores.count(pdf)) return;
+        try {
+            vector<TH1D*> hs = fit.getSource().read(pdf, 0.118, 0, 0);
+            if(hs.empty()) throw runtime_error(("No theory of " + pdf + " in the theory source").Data());
+            for(auto h : hs) delete h;
+            fit.readAllTheory(pdf, "16ak4", shmKey);
+        }
+        catch(...) {
+            fit.dropTheory(pdf, "16ak4");
+            throw;
+        }
+    }
+
+    //Restore the original sources and decorrelate them again
+    void setDecorrelation(TString dec)
+    {
+        if(dec == decNow) return;
+        map<TString, vector<int>> decMap;
+        if(!asFitter::parseDecMap(dec, decMap))
+            throw runtime_error(("Wrong decorrelation " + dec + ", use <source>:g0,g1,g2,g3;...").Data());
+        fit.data = data0;
+        ErrNames = names0;
+        fit.Decorrelate(decMap);
+        fit.ws.nErr = -1; //the solver buffers are sized again
+        decNow = dec;
+    }
+
+    static int parseTypes(TString list)
+    {
+        const map<TString, int> names = { {"simple", asFitter::chi2Simple}, {"hera", asFitter::chi2HERA}, {"heraNoNP", asFitter::chi2HERAnoNP},
+                                          {"heraNoPDF", asFitter::chi2HERAnoPDF}, {"naive", asFitter::chi2Naive}, {"cov", asFitter::chi2Cov} };
+        int types = 0;
+        for(auto n : splitString(list, ',')) {
+            if(!names.count(n)) throw runtime_error(("Unknown chi2 " + n).Data());
+            types |= names.at(n);
+        }
+        if(types == 0) throw runtime_error("No chi2 requested");
+        return types;
+    }
+
+    static vector<pair<TString,double>> getValues(const asFitter::chi2Result &r, int types)
+    {
+        vector<pair<TString,double>> v;
+        if(types & asFitter::chi2Simple)    v.push_back({"simple",    r.simple});
+        if(types & asFitter::chi2HERA)      v.push_back({"hera",      r.hera});
+        if(types & asFitter::chi2HERAnoNP)  v.push_back({"heraNoNP",  r.heraNoNP});
+        if(types & asFitter::chi2HERAnoPDF) v.push_back({"heraNoPDF", r.heraNoPDF});
+        if(types & asFitter::chi2Naive)     v.push_back({"naive",     r.naive});
+        if(types & asFitter::chi2Cov)       v.push_back({"cov",       r.cov});
+        return v;
+    }
+
+    TString answer(TString query)
+    {
+        auto t0 = chrono::steady_clock::now();
+
+        map<TString,TString> q;
+        for(auto w : splitString(query, ' ')) {
+            int eq = w.First('=');
+            if(eq <= 0) throw runtime_error(("Wrong word " + w + ", use key=value").Data());
+            q[w(0, eq)] = w(eq+1, w.Length());
+        }
+        const vector<TString> keys = {"pdf", "as", "scale", "order", "unc", "yMin", "yMax", "ptMin", "ptMax", "chi2", "dec"};
+        for(const auto &el : q)
+            if(find(keys.begin(), keys.end(), el.first) == keys.end())
+                throw runtime_error(("Unknown key " + el.first).Data());
+        auto get = [&](TString k, TString def) { return q.count(k) ? q.at(k) : def; };
+
+        TString pdf = get("pdf", "");
+        if(!pdfAsVals.count(pdf)) throw runtime_error(("Unknown pdf " + pdf).Data());
+        const vector<double> &asVals = pdfAsVals.at(pdf);
+        int scale = get("scale", "0").Atoi();
+        if(scale < 0 || scale >= 7) throw runtime_error("Scale choice must be 0..6");
+        double unc   = get("unc", "-1").Atof();
+        double yMin  = get("yMin", "0").Atof(),   yMax  = get("yMax", "2").Atof();
+        double ptMin = get("ptMin", "95").Atof(), ptMax = get("ptMax", "1e9").Atof();
+        int types = parseTypes(get("chi2", "hera"));
+
+        bool scan = get("as", "") == "scan";
+        double as = get("as", "0.118").Atof();
+        if(!scan && (as < asVals.front() - 1e-6 || as > asVals.back() + 1e-6))
+            throw runtime_error(Form("alphaS outside of [%g, %g]", asVals.front(), asVals.back()));
+
+        setDecorrelation(get("dec", "default"));
+        loadTheory(pdf);
+        fit.order = get("order", orderDef);
+        fit.Cut = [=](const point &p) {
+            return p.sigma != 0 && p.yMin > yMin - 1e-3 && p.yMax < yMax + 1e-3 && p.ptMin > ptMin - 1e-3 && p.ptMax < ptMax + 1e-3;
+        };
+        int nPoints = fit.getNpoints();
+        if(nPoints == 0) throw runtime_error("No points pass the cut");
+        fit.setUnCorr(unc);
+
+        vector<int> covIndx;
+        for(int i = 0; i < fit.data[0].errs.size(); ++i)
+            covIndx.push_back(i);
+
+        //the nuisance products are shared by the alphaS values (pdf variations at 0.118)
+        vector<double> asScan = scan ? fit.getAsScan(pdf) : vector<double>{as};
+        vector<asFitter::chi2Result> res;
+        asFitter::nuisProducts np;
+        try {
+            for(double a : asScan) {
+                fit.fillTheory(pdf, a, scale);
+                res.push_back(fit.getChi2s(types, np, covIndx));
+            }
+        }
+        catch(...) { //e.g. missing pdf members, read again at the next query
+            fit.dropTheory(pdf, "16ak4");
+            throw;
+        }
+
+        stringstream js;
+        js << setprecision(10);
+        js << "{\"ok\": true, \"pdf\": \"" << pdf << "\", \"order\": \"" << fit.order << "\", \"scale\": " << scale
+           << ", \"npoints\": " << nPoints << ", \"results\": [";
+        for(int i = 0; i < res.size(); ++i) {
+            js << (i ? ", " : "") << "{\"as\": " << asScan[i];
+            for(const auto &v : getValues(res[i], types))
+                js << ", \"" << v.first << "\": " << v.second;
+            js << "}";
+        }
+        js << "]";
+        if(scan) {
+            js << ", \"minimum\": {";
+            auto names = getValues(res[0], types);
+            for(int k = 0; k < names.size(); ++k) {
+                vector<double> chi2;
+                for(const auto &r : res)
+                    chi2.push_back(getValues(r, types)[k].second);
+                asFitResult f = fitAsPol4(asScan, chi2);
+                js << (k ? ", " : "") << "\"" << names[k].first << "\": {\"as\": " << f.asMin << ", \"errUp\": " << f.errUp
+                   << ", \"errDn\": " << f.errDn << ", \"chi2\": " << f.chi2Min << ", \"ok\": " << (f.ok ? "true" : "false") << "}";
+            }
+            js << "}";
+        }
+        js << ", \"ms\": " << chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count() << "}";
+        return js.str();
+    }
+
+    //Serve the clients one after another until shutdown
+    void run(TString sockName)
+    {
+        int lfd = listenUnix(sockName.Data());
+        cout << "Fit server listening at " << sockName << endl;
+        bool stop = false;
+        while(!stop) {
+            int fd = accept(lfd, nullptr, nullptr);
+            if(fd < 0) continue;
+            lineReader rd(fd);
+            string line;
+            while(!stop && rd.getLine(line)) {
+                TString qs = TString(line.c_str()).Strip(TString::kBoth);
+                if(qs == "") continue;
+                TString ans;
+                if(qs == "ping")          ans = "{\"ok\": true}";
+                else if(qs == "shutdown") { ans = "{\"ok\": true}"; stop = true; }
+                else {
+                    try {
+                        ans = answer(qs);
+                    }
+                    catch(const exception &e) {
+                        TString err = e.what();
+                        err.ReplaceAll("\"", "'");
+                        ans = "{\"ok\": false, \"error\": \"" + err + "\"}";
+                    }
+                }
+                if(!writeLine(fd, ans.Data())) break;
+            }
+            close(fd);
+        }
+        close(lfd);
+        unlink(sockName.Data());
+        cout << "Fit server stopped" << endl;
+    }
+};
+
+
+int main(int argc, char** argv)
+{
+    map<TString,TString> opts = {{"socket", "fitServer.sock"}, {"theory", "cmsJetsAsScan_ak4.root"},
+                                 {"data", "xFitterTables/table_16ak4_uncorr0.txt"}, {"order", "nnlo"}, {"shm", ""}};
+    for(int i = 1; i < argc; ++i) {
+        TString a = argv[i];
+        int eq = a.First('=');
+        TString key = a.BeginsWith("--") && eq > 2 ? TString(a(2, eq-2)) : TString("");
+        if(!opts.count(key)) {
+            cout << "Usage: " << argv[0] << " [--socket=fitServer.sock] [--theory=<spec>] [--data=<table>] [--order=nnlo] [--shm=<key>]" << endl;
+            return 1;
+        }
+        opts[key] = a(eq+1, a.Length());
+    }
+
+    fitServer srv(opts.at("data"), opts.at("theory"), opts.at("order"), opts.at("shm"));
+    srv.run(opts.at("socket"));
+    return 0;
+}
@@ -0,0 +1,96 @@
+#ifndef fitSocket_H
+#define fitSocket_H
+
+#include <string>
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+//Line-based messages over a Unix-domain socket, used by fitServer and fitClient
+//Each request and each answer is one line terminated by '\n'
+
+inline sockaddr_un getSocketAddress(const std::string &path)
+{
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if(path.size() >= sizeof(addr.sun_path)) {
+        std::cout << "Socket path " << path << " is too long" << std::endl;
+        exit(1);
+    }
+    strcpy(addr.sun_path, path.c_str());
+    return addr;
+}
+
+//Listening socket at path, an old socket file is removed
+inline int listenUnix(const std::string &path)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr = getSocketAddress(path);
+    unlink(path.c_str());
+    if(fd < 0 || bind(fd, (sockaddr*) &addr, sizeof(addr)) != 0 || listen(fd, 8) != 0) {
+        std::cout << "Cannot listen at " << path << " : " << strerror(errno) << std::endl;
+        exit(1);
+    }
+    return fd;
+}
+
+//Connected socket, -1 if nobody listens at path
+inline int connectUnix(const std::string &path)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr = getSocketAddress(path);
+    if(fd < 0) return -1;
+    if(connect(fd, (sockaddr*) &addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+//Reader of the lines from fd, the bytes after the newline are kept for the next call
+struct lineReader {
+    int fd;
+    std::string buf;
+
+    lineReader(int fd_) : fd(fd_) {}
+
+    //false at the end of the stream
+    bool getLine(std::string &line)
+    {
+        while(true) {
+            size_t nl = buf.find('\n');
+            if(nl != std::string::npos) {
+                line = buf.substr(0, nl);
+                buf.erase(0, nl+1);
+                return true;
+            }
+            char tmp[4096];
+            ssize_t n = read(fd, tmp, sizeof(tmp));
+            if(n < 0 && errno == EINTR) continue;
+            if(n <= 0) return false;
+            buf.append(tmp, n);
+        }
+    }
+};
+
+//Write the line (newline added), false if the peer is gone
+inline bool writeLine(int fd, const std::string &line)
+{
+    std::string msg = line + "\n";
+    size_t done = 0;
+    while(done < msg.size()) {
+        ssize_t n = send(fd, msg.data() + done, msg.size() - done, MSG_NOSIGNAL);
+        if(n < 0 && errno == EINTR) continue;
+        if(n <= 0) return false;
+        done += n;
+    }
+    return true;
+}
+
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef instrument_H
+#define instrument_H
+
+//Scoped timers and counters of the hot stages, enabled by -DINSTRUMENT (make ... INSTR=1), otherwise they compile to nothing
+//  INSTR_SCOPE("stage");      times the rest of the enclosing block
+//  INSTR_COUNT("counter", n); adds n to the counter
+//At exit a per-stage summary is printed to stderr and the Chrome trace-event JSON (chrome://tracing, Perfetto)
+//is written to $INSTR_TRACE (default instrTrace.json, "none" disables it)
+
+#ifdef INSTRUMENT
+
+#include <vector>
+#include <map>
+#include <string>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+struct instrument {
+    struct event {
+        const char *name;
+        double t0, dur; //microseconds from the start
+    };
+    struct stage {
+        long long n = 0;
+        double tot = 0, mn = 1e300, mx = 0; //microseconds
+    };
+    //Records of one thread, the threads write only to their own buffer
+    struct buffer {
+        int tid = 0;
+        std::map<const char*, stage> stages; //keyed by the literal
+        std::map<const char*, long long> counters;
+        std::vector<event> events;
+    };
+
+    static const size_t maxEvents = 1 << 20; //per thread, only the stage statistics are kept above
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::mutex mtx;
+    std::vector<buffer*> buffers; //kept until exit, also of the finished threads
+
+    static instrument &get() { static instrument I; return I; }
+
+    static buffer &local()
+    {
+        thread_local buffer *b = nullptr;
+        if(!b) {
+            instrument &I = get();
+            std::lock_guard<std::mutex> lock(I.mtx);
+            b = new buffer;
+            b->tid = I.buffers.size();
+            I.buffers.push_back(b);
+        }
+        return *b;
+    }
+
+    double now() const { return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count(); }
+
+    static void record(const char *name, double t0, double t1)
+    {
+        buffer &b = local();
+        stage &s = b.stages[name];
+        double d = t1 - t0;
+        ++s.n;
+        s.tot += d;
+        s.mn = std::min(s.mn, d);
+        s.mx = std::max(s.mx, d);
+        if(b.events.size() < maxEvents)
+            b.events.push_back({name, t0, d});
+    }
+
+    static void count(const char *name, long long n = 1) { local().counters[name] += n; }
+
+    struct scope {
+        const char *name;
+        double t0;
+        scope(const char *n) : name(n), t0(get().now()) {}
+        ~scope() { record(name, t0, get().now()); }
+    };
+
+    ~instrument()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        double wall = now();
+
+        //merge the threads, by name
+        std::map<std::string, stage> st;
+        std::map<std::string, long long> cnt;
+        for(auto b : buffers) {
+            for(const auto &s : b->stages) {
+                stage &m = st[s.first];
+                m.n  += s.second.n;
+                m.tot += s.second.tot;
+                m.mn = std::min(m.mn, s.second.mn);
+                m.mx = std::max(m.mx, s.second.mx);
+            }
+            for(const auto &c : b->counters)
+                cnt[c.first] += c.second;
+        }
+
+        fprintf(stderr, "\nInstrumentation summary (wall %.3f s, times summed over threads)\n", wall*1e-6);
+        fprintf(stderr, "%-28s %12s %12s %8s %12s %12s %12s\n", "stage", "calls", "total [s]", "wall %", "mean [us]", "min [us]", "max [us]");
+        for(const auto &s : st)
+            fprintf(stderr, "%-28s %12lld %12.4f %8.2f %12.2f %12.2f %12.2f\n", s.first.c_str(), s.second.n, s.second.tot*1e-6,
+                    100*s.second.tot/wall, s.second.tot/s.second.n, s.second.mn, s.second.mx);
+        if(!cnt.empty())
+            fprintf(stderr, "%-28s %12s\n", "counter", "total");
+        for(const auto &c : cnt)
+            fprintf(stderr, "%-28s %12lld\n", c.first.c_str(), c.second);
+
+        const char *env = getenv("INSTR_TRACE");
+        std::string fName = env ? env : "instrTrace.json";
+        if(fName == "none" || fName == "") return;
+        FILE *f = fopen(fName.c_str(), "w");
+        if(!f) {
+            fprintf(stderr, "Cannot write trace to %s\n", fName.c_str());
+            return;
+        }
+        fprintf(f, "{\"traceEvents\": [\n");
+        bool first = true;
+        for(auto b : buffers)
+            for(const auto &e : b->events) {
+                fprintf(f, "%s{\"name\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %d}",
+                        first ? "" : ",\n", e.name, e.t0, e.dur, b->tid);
+                first = false;
+            }
+        fprintf(f, "\n], \"displayTimeUnit\": \"ms\"}\n");
+        fclose(f);
+        fprintf(stderr, "Trace written to %s\n", fName.c_str());
+    }
+};
+
+#define INSTR_CAT2(a, b) a##b
+#define INSTR_CAT(a, b)  INSTR_CAT2(a, b)
+#define INSTR_SCOPE(name)    instrument::scope INSTR_CAT(instrScope_, __LINE__)(name)
+#define INSTR_COUNT(name, n) instrument::count(name, n)
+
+#else
+
+#define INSTR_SCOPE(name)    ((void)0)
+#define INSTR_COUNT(name, n) ((void)0)
+
+#endif
+
+#endif
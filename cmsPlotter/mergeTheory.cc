@@ -0,0 +1,164 @@
+//Merge of the shards of the alphaS scan of calcTheory (--shard=<i>/<N>) to one theory file
+//  ./mergeTheory <output.root> <shard files...>
+//All shards must come from the same task list (same signature) and together cover every task exactly once,
+//otherwise nothing is written and the missing and duplicated tasks are listed.
+//The histograms are written in the task order, so the result does not depend on the number of shards
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+
+#include "TH1D.h"
+#include "TFile.h"
+#include "TNamed.h"
+#include "TString.h"
+
+using namespace std;
+
+struct shardTask {
+    int file = -1;          //shard file with the task
+    TString pdf;
+    vector<TString> hists;  //histograms of the task (one per rapidity)
+};
+
+int main(int argc, char** argv)
+{
+    if(argc < 3) {
+        cout << "Usage: " << argv[0] << " <output.root> <shard files...>" << endl;
+        return 1;
+    }
+    TString outName = argv[1];
+    TH1::AddDirectory(false);
+
+    vector<TFile*> files;
+    vector<shardTask> tasks;
+    vector<vector<int>> owners; //[task] -> shard files which evaluated it
+    TString sig;
+    for(int i = 2; i < argc; ++i) {
+        TFile *f = TFile::Open(argv[i]);
+        if(!f || f->IsZombie()) {
+            cout << "Shard " << argv[i] << " cannot be opened" << endl;
+            return 1;
+        }
+        TNamed *shard = (TNamed*) f->Get("scanShard");
+        TNamed *list  = (TNamed*) f->Get("scanTasks");
+        if(!shard || !list) {
+            cout << argv[i] << " is not a shard of calcTheory --shard" << endl;
+            return 1;
+        }
+        int iShard, nShards, nTasks;
+        char sigNow[64];
+        if(sscanf(shard->GetTitle(), "%d %d %d %63s", &iShard, &nShards, &nTasks, sigNow) != 4) {
+            cout << "Wrong shard header of " << argv[i] << " : " << shard->GetTitle() << endl;
+            return 1;
+        }
+        if(files.empty()) {
+            sig = sigNow;
+            tasks.resize(nTasks);
+            owners.resize(nTasks);
+        }
+        else if(sig != sigNow || nTasks != (int) tasks.size()) {
+            cout << argv[i] << " belongs to another scan (" << nTasks << " tasks, signature " << sigNow << "), expected "
+                 << tasks.size() << " tasks, signature " << sig << endl;
+            return 1;
+        }
+        files.push_back(f);
+        cout << argv[i] << " : shard " << iShard << " of " << nShards << endl;
+
+        //lines "<task> <pdf> <histograms...>"
+        stringstream ss(list->GetTitle());
+        string line;
+        while(getline(ss, line)) {
+            stringstream ls(line);
+            int t;
+            string pdf, h;
+            if(!(ls >> t >> pdf)) continue;
+            if(t < 0 || t >= nTasks) {
+                cout << "Task " << t << " of " << argv[i] << " is out of range" << endl;
+                return 1;
+            }
+            owners[t].push_back(files.size()-1);
+            if(owners[t].size() > 1) continue;
+            tasks[t].file = files.size()-1;
+            tasks[t].pdf  = pdf;
+            while(ls >> h)
+                tasks[t].hists.push_back(h);
+        }
+    }
+
+    //every task exactly once
+    int nMissing = 0, nDupl = 0;
+    for(int t = 0; t < (int) tasks.size(); ++t) {
+        if(owners[t].size() == 0) {
+            if(nMissing++ < 20) cout << "Missing task " << t << endl;
+        }
+        else if(owners[t].size() > 1) {
+            if(nDupl++ < 20) {
+                cout << "Duplicated task " << t << " in";
+                for(int k : owners[t]) cout << " " << files[k]->GetName();
+                cout << endl;
+            }
+        }
+    }
+    if(nMissing || nDupl) {
+        cout << nMissing << " missing and " << nDupl << " duplicated tasks out of " << tasks.size() << ", nothing written" << endl;
+        return 1;
+    }
+
+    //written to a temporary file first, so a failed merge leaves no output
+    TString tmpName = outName + ".tmp";
+    TFile *fOut = TFile::Open(tmpName, "RECREATE");
+    vector<TString> pdfs;
+    map<TString, int> pdfFile; //shard with the errType of the pdf
+    for(const auto &tk : tasks) {
+        if(!pdfFile.count(tk.pdf)) {
+            pdfs.push_back(tk.pdf);
+            pdfFile[tk.pdf] = tk.file;
+        }
+        for(auto n : tk.hists) {
+            TH1D *h = (TH1D*) files[tk.file]->Get(n);
+            if(!h) {
+                cout << "Histogram " << n << " is missing in " << files[tk.file]->GetName() << endl;
+                fOut->Close();
+                remove(tmpName.Data());
+                return 1;
+            }
+            fOut->cd();
+            h->Write(n);
+            delete h;
+        }
+    }
+
+    //pdf uncertainty types, the same in all shards
+    for(auto pdf : pdfs) {
+        TString n = pdf + "_errType";
+        TNamed *et = (TNamed*) files[pdfFile.at(pdf)]->Get(n);
+        for(auto f : files) {
+            TNamed *other = (TNamed*) f->Get(n);
+            if(et && other && TString(et->GetTitle()) != other->GetTitle()) {
+                cout << "Different " << n << " in " << files[pdfFile.at(pdf)]->GetName() << " and " << f->GetName() << endl;
+                fOut->Close();
+                remove(tmpName.Data());
+                return 1;
+            }
+        }
+        if(!et) {
+            cout << n << " is missing" << endl;
+            fOut->Close();
+            remove(tmpName.Data());
+            return 1;
+        }
+        fOut->cd();
+        TNamed(n, et->GetTitle()).Write(n);
+    }
+    fOut->Close();
+    if(rename(tmpName.Data(), outName.Data()) != 0) {
+        cout << "Cannot write " << outName << endl;
+        return 1;
+    }
+    cout << tasks.size() << " tasks of " << files.size() << " shards merged to " << outName << endl;
+    return 0;
+}
@@ -0,0 +1,161 @@
+#ifndef pdfUnc_H
+#define pdfUnc_H
+
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <cmath>
+
+#include "TString.h"
+#include "TMath.h"
+
+//Kind of the pdf uncertainty of an LHAPDF set, given by ErrorType and ErrorConfLevel of the set metadata
+struct pdfErrType {
+    enum kind {hessian, symmhessian, replicas};
+    kind   type  = hessian;
+    double cl    = 100*TMath::Erf(1/sqrt(2.)); //confidence level of the variations in %
+    int    nCore = 0; //number of error members (without the +as extras)
+
+    //factor converting the variations to one sigma
+    double getScale() const { return type == replicas ? 1 : TMath::ErfInverse(cl/100) * sqrt(2.); }
+
+    //number of nuisance parameters: one per eigenvector pair, symmetric eigenvector or replica
+    int nNuis() const { return type == hessian ? nCore/2 : nCore; }
+
+    //e.g. "hessian 90 56", the form stored in the theory file
+    TString toString() const
+    {
+        const char *names[] = {"hessian", "symmhessian", "replicas"};
+        return Form("%s %g %d", names[type], cl, nCore);
+    }
+
+    static pdfErrType fromString(TString str)
+    {
+        std::stringstream ss(str.Data());
+        std::string t;
+        double cl;
+        int nCore;
+        ss >> t >> cl >> nCore;
+        return fromInfo(t.c_str(), cl, nCore+1);
+    }
+
+    //From the metadata, nMembers includes the central member
+    //each "+xx" extra (e.g. +as) adds two members at the end of the set, they are not part of the pdf unc.
+    static pdfErrType fromInfo(TString errorType, double confLevel, int nMembers)
+    {
+        pdfErrType et;
+        TString core = errorType;
+        int nExtra = 0;
+        if(errorType.First('+') >= 0) {
+            core = errorType(0, errorType.First('+'));
+            for(int i = 0; i < errorType.Length(); ++i)
+                nExtra += errorType[i] == '+';
+        }
+        if(core == "hessian")          et.type = hessian;
+        else if(core == "symmhessian") et.type = symmhessian;
+        else if(core == "replicas")    et.type = replicas;
+        else {
+            std::cout << "Unknown pdf ErrorType " << errorType << std::endl;
+            exit(1);
+        }
+        if(confLevel > 0) et.cl = confLevel;
+        et.nCore = nMembers - 1 - 2*nExtra;
+        return et;
+    }
+
+    //Guess from the set name, used for theory files without the metadata
+    static pdfErrType fromName(TString pdfName, int nMembers)
+    {
+        pdfErrType et;
+        if(pdfName.Contains("ABMP16") || pdfName.Contains("NNPDF31"))
+            et.type = symmhessian;
+        if(pdfName.Contains("CT14"))
+            et.cl = 90;
+        et.nCore = nMembers - 1;
+        return et;
+    }
+};
+
+
+//Streaming reduction of the pdf members to the central value and one-sigma up/dn uncertainties
+//Members are added one by one in the LHAPDF order (0 = central), memory is O(bins) for any number of members
+//  hessian     : up/dn = sqrt(sum max(X+ - X0, X- - X0, 0)^2) resp. with the opposite sign, divided by the CL factor
+//  symmhessian : up = dn = sqrt(sum (Xi - X0)^2), divided by the CL factor
+//  replicas    : up = dn = standard deviation of the replicas (Welford)
+struct pdfUncAccumulator {
+    pdfErrType et;
+    int nAdded = 0;
+    std::vector<double> cnt;       //central member
+    std::vector<double> up2, dn2;  //hessian sums
+    std::vector<double> prev;      //first member of the current hessian pair
+    std::vector<double> mean, m2;  //replica statistics
+
+    pdfUncAccumulator(pdfErrType et_) : et(et_) {}
+
+    void add(const std::vector<double> &v)
+    {
+        int imem = nAdded++;
+        if(imem == 0) {
+            cnt = v;
+            up2.assign(v.size(), 0.);
+            dn2.assign(v.size(), 0.);
+            mean.assign(v.size(), 0.);
+            m2.assign(v.size(), 0.);
+            return;
+        }
+        if(imem > et.nCore) return; //the +as members
+
+        if(et.type == pdfErrType::symmhessian) {
+            for(int b = 0; b < v.size(); ++b) {
+                double d = v[b] - cnt[b];
+                up2[b] += d*d;
+                dn2[b] += d*d;
+            }
+        }
+        else if(et.type == pdfErrType::hessian) {
+            if(imem % 2 == 1) { //wait for the second member of the pair
+                prev = v;
+                return;
+            }
+            for(int b = 0; b < v.size(); ++b) {
+                double dP = prev[b] - cnt[b];
+                double dM = v[b]    - cnt[b];
+                double up = std::max(std::max(dP, dM), 0.);
+                double dn = std::max(std::max(-dP, -dM), 0.);
+                up2[b] += up*up;
+                dn2[b] += dn*dn;
+            }
+        }
+        else {
+            for(int b = 0; b < v.size(); ++b) {
+                double d = v[b] - mean[b];
+                mean[b] += d / imem;
+                m2[b]   += d * (v[b] - mean[b]);
+            }
+        }
+    }
+
+    int nUsed() const { return std::min(nAdded - 1, et.nCore); }
+
+    //Central value and one-sigma up and dn uncertainties (positive numbers)
+    void getResult(std::vector<double> &c, std::vector<double> &up, std::vector<double> &dn) const
+    {
+        c = cnt;
+        up.resize(cnt.size());
+        dn.resize(cnt.size());
+        for(int b = 0; b < cnt.size(); ++b) {
+            if(et.type == pdfErrType::replicas) {
+                double sd = nUsed() > 1 ? sqrt(m2[b] / (nUsed() - 1)) : 0;
+                up[b] = dn[b] = sd;
+            }
+            else {
+                up[b] = sqrt(up2[b]) / et.getScale();
+                dn[b] = sqrt(dn2[b]) / et.getScale();
+            }
+        }
+    }
+};
+
+
+#endif
@@ -0,0 +1,157 @@
+//Implementation of rebin.h, part of libAsFitter.so
+#include <vector>
+#include <map>
+#include <mutex>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <numeric>
+#include <iostream>
+
+#include "rebin.h"
+
+using namespace std;
+
+//The overlaps are found by one pass over both (increasing) edge lists
+rebinMatrix::rebinMatrix(const vector<double> &from_, const vector<double> &to_, int md) : from(from_), to(to_)
+{
+    start.assign(1, 0);
+    int i = 0;
+    vector<double> ov; //overlaps of the current row
+    for(int j = 0; j < nTo(); ++j) {
+        ov.clear();
+        while(i < nFrom() && from[i+1] <= to[j]) ++i;
+        for(int k = i; k < nFrom() && from[k] < to[j+1]; ++k) {
+            double o = min(from[k+1], to[j+1]) - max(from[k], to[j]);
+            if(o > 1e-9 * (from[k+1] - from[k])) { //slivers from rounded edges are skipped
+                col.push_back(k);
+                ov.push_back(o);
+            }
+        }
+        double norm = md == average ? accumulate(ov.begin(), ov.end(), 0.) : to[j+1] - to[j];
+        for(double o : ov)
+            w.push_back(o / norm);
+        start.push_back(col.size());
+    }
+}
+
+void rebinMatrix::apply(const double *x, double *y) const
+{
+    for(int j = 0; j < nTo(); ++j) {
+        double s = 0;
+        for(int k = start[j]; k < start[j+1]; ++k)
+            s += w[k] * x[col[k]];
+        y[j] = s;
+    }
+}
+
+vector<double> rebinMatrix::apply(const vector<double> &x) const
+{
+    vector<double> y(nTo());
+    apply(x.data(), y.data());
+    return y;
+}
+
+void rebinMatrix::apply(const double *X, double *Y, int nCol) const
+{
+    for(int j = 0; j < nTo(); ++j) {
+        double *yj = Y + j*nCol;
+        fill(yj, yj + nCol, 0.);
+        for(int k = start[j]; k < start[j+1]; ++k) {
+            const double *xi = X + col[k]*nCol;
+            double wk = w[k];
+            for(int c = 0; c < nCol; ++c)
+                yj[c] += wk * xi[c];
+        }
+    }
+}
+
+TH1D *rebinMatrix::apply(const TH1 *h, const TH1 *hTemp) const
+{
+    TH1D *hNew;
+    if(hTemp) { //keeps the titles and the style of the template
+        hNew = (TH1D *) hTemp->Clone(Form("%d",rand()));
+        hNew->Reset();
+    }
+    else
+        hNew = new TH1D(Form("%d",rand()), h->GetTitle(), nTo(), to.data());
+    for(int j = 0; j < nTo(); ++j) {
+        double v = 0, e2 = 0;
+        for(int k = start[j]; k < start[j+1]; ++k) {
+            v  += w[k] * h->GetBinContent(col[k]+1);
+            e2 += pow(w[k] * h->GetBinError(col[k]+1), 2);
+        }
+        hNew->SetBinContent(j+1, v);
+        hNew->SetBinError(j+1, sqrt(e2));
+    }
+    return hNew;
+}
+
+vector<TH1D*> rebinMatrix::apply(const vector<TH1D*> &hs, const TH1 *hTemp) const
+{
+    vector<TH1D*> res;
+    for(auto h : hs)
+        res.push_back(apply(h, hTemp));
+    return res;
+}
+
+void rebinMatrix::multiply(TH1 *h, const TH1 *hCorr) const
+{
+    for(int j = 0; j < nTo(); ++j) {
+        double c = 0;
+        for(int k = start[j]; k < start[j+1]; ++k)
+            c += w[k] * hCorr->GetBinContent(col[k]+1);
+        h->SetBinContent(j+1, h->GetBinContent(j+1) * c);
+        h->SetBinError(j+1, h->GetBinError(j+1) * c);
+    }
+}
+
+vector<double> rebinMatrix::getEdges(const TH1 *h)
+{
+    vector<double> edges;
+    for(int i = 1; i <= h->GetNbinsX(); ++i)
+        edges.push_back(h->GetBinLowEdge(i));
+    edges.push_back(h->GetBinLowEdge(h->GetNbinsX()) + h->GetBinWidth(h->GetNbinsX()));
+    return edges;
+}
+
+const rebinMatrix &getRebinMatrix(const TH1 *h, const TH1 *hTemp, int md)
+{
+    static map<pair<int, pair<vector<double>,vector<double>>>, rebinMatrix> cache;
+    static mutex mtx;
+    auto key = make_pair(md, make_pair(rebinMatrix::getEdges(h), rebinMatrix::getEdges(hTemp)));
+    lock_guard<mutex> lock(mtx);
+    auto it = cache.find(key);
+    if(it == cache.end())
+        it = cache.emplace(key, rebinMatrix(key.second.first, key.second.second, md)).first;
+    return it->second; //map elements are never moved
+}
+
+TH1D *rebin(TH1D *h, TH1D *hTemp)
+{
+    return getRebinMatrix(h, hTemp).apply(h, hTemp);
+}
+
+//Target binning are the bins of hTemp with non-zero content
+TH1D *rebinToNonZero(TH1D *h, TH1D *hTemp)
+{
+    vector<double> bins;
+    int last = 0;
+    for(int i = 1; i <= hTemp->GetNbinsX(); ++i)
+        if(hTemp->GetBinContent(i) > 1e-15) {
+            bins.push_back(hTemp->GetBinLowEdge(i));
+            last = i;
+        }
+    if(last == 0) {
+        cout << "Template histogram " << hTemp->GetName() << " has no non-zero bin" << endl;
+        exit(1);
+    }
+    bins.push_back(hTemp->GetBinLowEdge(last) + hTemp->GetBinWidth(last));
+
+    return rebinMatrix(rebinMatrix::getEdges(h), bins).apply(h, nullptr);
+}
+
+TH1D *rebinAverage(TH1D *h, TH1D *hTemp)
+{
+    return getRebinMatrix(h, hTemp, rebinMatrix::average).apply(h, hTemp);
+}
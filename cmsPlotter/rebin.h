@@ -0,0 +1,59 @@
+#ifndef rebin_H
+#define rebin_H
+
+#include <vector>
+
+#include "TH1D.h"
+
+//Rebinning of the cross-section histograms (contents per bin width), compiled to libAsFitter.so (rebin.cc)
+
+//Sparse overlap matrix between two binnings, computed once and applied to any number of histograms
+//Row j (target bin) holds the source bins i overlapping with it, the content of a source bin is taken as uniform
+//  density : y_j = sum_i x_i * overlap_ji / width_j         (cross sections, part of the target bin without source counts as zero)
+//  average : y_j = sum_i x_i * overlap_ji / sum_i overlap_ji (corrections, ratios; zero for a target bin without source)
+//The errors are added in quadrature with the same weights
+struct rebinMatrix {
+    enum mode {density, average};
+
+    std::vector<double> from, to; //bin edges
+    std::vector<int> start;       //row j is [start[j], start[j+1])
+    std::vector<int> col;         //source bin (0-based)
+    std::vector<double> w;        //weight
+
+    rebinMatrix() {}
+    rebinMatrix(const std::vector<double> &from_, const std::vector<double> &to_, int md = density);
+    rebinMatrix(const TH1 *h, const TH1 *hTemp, int md = density) : rebinMatrix(getEdges(h), getEdges(hTemp), md) {}
+
+    int nFrom() const { return from.size() - 1; }
+    int nTo()   const { return to.size() - 1; }
+
+    //y = W x, x has nFrom() values and y nTo()
+    void apply(const double *x, double *y) const;
+    std::vector<double> apply(const std::vector<double> &x) const;
+
+    //Y = W X for nCol columns (e.g. pdf members), X is [nFrom()][nCol] and Y [nTo()][nCol], row-major
+    void apply(const double *X, double *Y, int nCol) const;
+
+    //New histogram with the contents and errors of h in the bins of to, a clone of hTemp (same binning as to) if given
+    TH1D *apply(const TH1 *h, const TH1 *hTemp) const;
+    std::vector<TH1D*> apply(const std::vector<TH1D*> &hs, const TH1 *hTemp) const;
+
+    //Corrections of hCorr multiplied to the bins of h, in place (hCorr binning is from, h binning is to)
+    void multiply(TH1 *h, const TH1 *hCorr) const;
+
+    static std::vector<double> getEdges(const TH1 *h);
+};
+
+//Matrix between the binnings of h and hTemp, cached, so repeated calls with the same binnings share it
+const rebinMatrix &getRebinMatrix(const TH1 *h, const TH1 *hTemp, int md = rebinMatrix::density);
+
+//Cross section h in the binning of hTemp (overlap weighted, partial bins split), errors added in quadrature
+TH1D *rebin(TH1D *h, TH1D *hTemp); //second is template
+
+//As rebin, the bins where hTemp is zero are removed
+TH1D *rebinToNonZero(TH1D *h, TH1D *hTemp); //second is template, zero bins are removed
+
+//Correction or ratio h averaged to the binning of hTemp
+TH1D *rebinAverage(TH1D *h, TH1D *hTemp); //second is template
+
+#endif
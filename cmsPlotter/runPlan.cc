@@ -0,0 +1,435 @@
+//Run planner: the theory calculations, the corrections and the fits of a campaign are declared in a plan file,
+//the planner builds their dependency graph and runs only the nodes with outdated outputs, in parallel
+//  ./runPlan <plan file> [--jobs=N] [--dry] [--force]
+//    --dry    only print the nodes and their state
+//    --force  run all nodes, also the up-to-date ones
+//Plan file, "key = values" lines (values separated by spaces), # starts a comment:
+//  dataset = <tag>:<data table>:<R>     e.g. 16ak4:xFitterTables/table_16ak4_uncorr0.txt:4
+//  pdf     = CT14nnlo NNPDF31_nnlo      pdf sets
+//  order   = nlo nnlo                   orders of the fits
+//  unCorr  = -1,0,1                     uncorrelated errors of a fit (one chi2 table per order)
+//  scales  = 0,1,2,3,4,5,6              scanned scale choices
+//  asStep  = 0.0005                     alphaS step of the scans (0 = the computed values)
+//  cut     = <name>:<yMax>:<ptMin>      e.g. central:1.6:95
+//  dec     = <name>:<spec>              decorrelation, spec as fitTheory --dec (default and none are predefined)
+//  theory  = fastnlo|mock               predictions of calcTheory
+//  out     = plan                       output directory
+//  jobs    = 0                          parallel nodes, 0 = number of cores
+//Each (R, pdf) is one theory node which computes all alphaS values and scale choices of the pdf set,
+//each (dataset, pdf, order, cut, dec) is one fit node. The corrections node converts the NP, EW and k-factor tables
+//of the used years and radii to <out>/corrs/np_ew.root, if some tables are missing the fits use theorFiles/corrs/np_ew.root.
+//A node is up to date if its outputs are newer than its inputs.
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+using namespace std;
+
+static vector<string> splitString(const string &s, char sep)
+{
+    vector<string> v;
+    stringstream ss(s);
+    string w;
+    while(getline(ss, w, sep))
+        if(w != "") v.push_back(w);
+    return v;
+}
+
+//modification time of the file, -1 if it does not exist
+static double getMtime(const string &f)
+{
+    struct stat st;
+    if(stat(f.c_str(), &st) != 0) return -1;
+    return st.st_mtim.tv_sec + 1e-9*st.st_mtim.tv_nsec;
+}
+
+//mkdir -p of the directory of the file
+static void makeDirFor(const string &f)
+{
+    size_t p = 0;
+    while((p = f.find('/', p+1)) != string::npos) {
+        string d = f.substr(0, p);
+        if(mkdir(d.c_str(), 0755) != 0 && errno != EEXIST) {
+            cout << "Cannot create directory " << d << " : " << strerror(errno) << endl;
+            exit(1);
+        }
+    }
+}
+
+struct node {
+    enum status {waiting, upToDate, running, done, failed, skipped};
+    string name;            //unique, e.g. theory_ak4_CT14nnlo
+    string cmd;             //shell command
+    vector<string> inputs;  //files, also the outputs of other nodes
+    vector<string> outputs;
+    vector<int> deps;       //nodes producing the inputs
+    status st = waiting;
+    pid_t pid = 0;
+};
+
+struct runPlan {
+    map<string, vector<string>> cfg;
+    vector<node> nodes;
+    map<string, int> byName, producer; //node index by name and by output file
+    vector<int> order;                 //topological
+
+    void readPlan(string fName)
+    {
+        ifstream f(fName);
+        if(!f.good()) {
+            cout << "Plan " << fName << " not found" << endl;
+            exit(1);
+        }
+        const set<string> keys = {"dataset", "pdf", "order", "unCorr", "scales", "asStep", "cut", "dec", "theory", "out", "jobs"};
+        string line;
+        for(int l = 1; getline(f, line); ++l) {
+            line = line.substr(0, line.find('#'));
+            if(line.find_first_not_of(" \t") == string::npos) continue;
+            size_t eq = line.find('=');
+            vector<string> key = eq == string::npos ? vector<string>() : splitString(line.substr(0, eq), ' ');
+            if(key.size() != 1 || !keys.count(key[0])) {
+                cout << fName << ":" << l << " wrong line \"" << line << "\", use <key> = <values>" << endl;
+                exit(1);
+            }
+            for(auto v : splitString(line.substr(eq+1), ' '))
+                for(auto w : splitString(v, '\t'))
+                    cfg[key[0]].push_back(w);
+        }
+    }
+
+    vector<string> get(string key, vector<string> def) const { return cfg.count(key) ? cfg.at(key) : def; }
+    string get1(string key, string def) const
+    {
+        auto v = get(key, {def});
+        if(v.size() != 1) {
+            cout << "Key " << key << " takes a single value" << endl;
+            exit(1);
+        }
+        return v[0];
+    }
+
+    //the node with the same name is added only once (e.g. the theory shared by several fits)
+    int addNode(node n)
+    {
+        if(byName.count(n.name)) return byName.at(n.name);
+        for(auto o : n.outputs) {
+            if(producer.count(o)) {
+                cout << "Output " << o << " of " << n.name << " is produced also by " << nodes[producer.at(o)].name << endl;
+                exit(1);
+            }
+            producer[o] = nodes.size();
+        }
+        byName[n.name] = nodes.size();
+        nodes.push_back(n);
+        return nodes.size() - 1;
+    }
+
+    static string fastNLOtable(int R)
+    {
+        if(R == 4) return "theorFiles/InclusiveNJets_fnl5362h_v23_fix.tab";
+        if(R == 7) return "theorFiles/InclusiveNJets_fnl5332h_v23_fix.tab";
+        cout << "No fastNLO table for R = " << R << endl;
+        exit(1);
+    }
+
+    void build()
+    {
+        string out   = get1("out", "plan");
+        string theory = get1("theory", "fastnlo");
+        if(theory != "fastnlo" && theory != "mock") {
+            cout << "Use theory = fastnlo|mock" << endl;
+            exit(1);
+        }
+        bool mock = theory == "mock";
+
+        auto datasets = get("dataset", {});
+        if(datasets.empty()) {
+            cout << "No dataset in the plan" << endl;
+            exit(1);
+        }
+        for(auto ds : datasets) {
+            auto w = splitString(ds, ':');
+            if(w.size() != 3 || (w[2] != "4" && w[2] != "7")) {
+                cout << "Use dataset = <tag>:<data table>:<R>, R = 4 or 7" << endl;
+                exit(1);
+            }
+        }
+
+        //NP and EW corrections and k-factors of the datasets (year from the tag as in applyNPEW), used by the fits (tools.h)
+        //They go to the plan directory, the complete theorFiles/corrs/np_ew.root (also read by the plotting macros) is not touched
+        //and is used as it is if some of the tables are missing
+        const string corrRepo = "theorFiles/corrs/np_ew.root";
+        string corrFile = out + "/corrs/np_ew.root";
+        set<string> corrNames;
+        for(auto ds : datasets) {
+            auto w = splitString(ds, ':');
+            string yr = w[0].find("15") != string::npos ? "15" : "16";
+            for(auto c : {"ew" + yr, "np" + yr, string("kFactorNLL"), string("kFactorNNLO")})
+                corrNames.insert(c + "_ak" + w[2]);
+        }
+        node corr;
+        corr.name = "corrections";
+        corr.cmd  = "python theorFiles/corrs/toRoot.py --out=" + corrFile;
+        bool corrTables = true;
+        for(auto c : corrNames) {
+            string f = "theorFiles/corrs/" + c + ".txt";
+            corr.cmd += " " + c;
+            corr.inputs.push_back(f);
+            if(getMtime(f) < 0) {
+                cout << "Correction table " << f << " is missing, " << corrRepo << " is used" << endl;
+                corrTables = false;
+            }
+        }
+        corr.inputs.push_back("theorFiles/corrs/toRoot.py");
+        corr.outputs = {corrFile};
+        if(!corrTables) corrFile = corrRepo;
+
+        map<string, string> decs = {{"default", "default"}, {"none", "none"}};
+        for(auto d : get("dec", {})) {
+            size_t c = d.find(':');
+            if(c == string::npos && decs.count(d)) continue;
+            if(c == string::npos || c == 0) {
+                cout << "Use dec = <name>:<spec>, default or none" << endl;
+                exit(1);
+            }
+            decs[d.substr(0, c)] = d.substr(c+1);
+        }
+        vector<string> decNames;
+        for(auto d : get("dec", {"default:default"}))
+            decNames.push_back(d.substr(0, d.find(':')));
+
+        vector<vector<string>> cuts;
+        for(auto c : get("cut", {"central:1.6:95"})) {
+            auto w = splitString(c, ':');
+            if(w.size() != 3) {
+                cout << "Use cut = <name>:<yMax>:<ptMin>" << endl;
+                exit(1);
+            }
+            cuts.push_back(w);
+        }
+
+        string unCorr = get1("unCorr", "-1");
+        string scales = get1("scales", "0,1,2,3,4,5,6");
+        string asStep = get1("asStep", "0");
+
+        for(auto ds : datasets) {
+            auto w = splitString(ds, ':');
+            string tag = w[0], table = w[1], R = w[2];
+            for(auto pdf : get("pdf", {"CT14nnlo"})) {
+                node th;
+                th.name = "theory_ak" + R + "_" + pdf;
+                string thFile = out + "/theory/ak" + R + "_" + pdf + ".root";
+                th.cmd = "./calcTheory" + string(mock ? " --mock" : "") + " --R=" + R + " --pdf=" + pdf + " --out=" + thFile;
+                th.inputs = {"./calcTheory"};
+                if(!mock) th.inputs.push_back(fastNLOtable(stoi(R)));
+                th.outputs = {thFile};
+                addNode(th);
+
+                for(auto ord : get("order", {"nnlo"}))
+                for(auto &cut : cuts)
+                for(auto dec : decNames) {
+                    node fit;
+                    fit.name = "fit_" + tag + "_" + pdf + "_" + ord + "_" + cut[0] + "_" + dec;
+                    string fitFile = out + "/fits/" + tag + "_" + pdf + "_" + ord + "_" + cut[0] + "_" + dec + ".root";
+                    fit.cmd = "./fitTheory " + ord + " " + unCorr + " --tag=" + tag + " --pdf=" + pdf + " --data=" + table +
+                              " --theory=" + thFile + " \"--dec=" + decs.at(dec) + "\" --yMax=" + cut[1] + " --ptMin=" + cut[2] +
+                              " --scales=" + scales + " --asStep=" + asStep + " --corrs=" + corrFile + " --out=" + fitFile;
+                    fit.inputs  = {"./fitTheory", "libAsFitter.so", table, thFile, corrFile};
+                    fit.outputs = {fitFile};
+                    if(corrTables) addNode(corr); //otherwise the repository np_ew.root is a source input
+                    addNode(fit);
+                }
+            }
+        }
+
+        //the edges, inputs without a producer must exist already
+        for(auto &n : nodes)
+            for(auto i : n.inputs)
+                if(producer.count(i))
+                    n.deps.push_back(producer.at(i));
+
+        //Kahn's topological sort
+        vector<int> nIn(nodes.size(), 0);
+        vector<vector<int>> users(nodes.size());
+        for(int i = 0; i < (int) nodes.size(); ++i)
+            for(int d : nodes[i].deps) {
+                ++nIn[i];
+                users[d].push_back(i);
+            }
+        for(int i = 0; i < (int) nodes.size(); ++i)
+            if(nIn[i] == 0) order.push_back(i);
+        for(int k = 0; k < (int) order.size(); ++k)
+            for(int u : users[order[k]])
+                if(--nIn[u] == 0) order.push_back(u);
+        if(order.size() != nodes.size()) {
+            cout << "The plan contains a dependency cycle" << endl;
+            exit(1);
+        }
+    }
+
+    //up to date: all outputs exist, are newer than the inputs and no dependency is rerun
+    void checkStatus(bool force)
+    {
+        for(int i : order) {
+            node &n = nodes[i];
+            bool fresh = !force;
+            for(int d : n.deps)
+                if(nodes[d].st != node::upToDate) fresh = false;
+            double tIn = -1;
+            for(auto f : n.inputs)
+                tIn = max(tIn, getMtime(f));
+            for(auto f : n.outputs) {
+                double t = getMtime(f);
+                if(t < 0 || t < tIn) fresh = false;
+            }
+            if(fresh) {
+                n.st = node::upToDate;
+                continue;
+            }
+            for(auto f : n.inputs)
+                if(!producer.count(f) && getMtime(f) < 0) {
+                    cout << "Input " << f << " of " << n.name << " is missing" << endl;
+                    n.st = node::failed;
+                }
+        }
+    }
+
+    string logFile(const node &n) const { return get1("out", "plan") + "/logs/" + n.name + ".log"; }
+
+    pid_t launch(node &n)
+    {
+        for(auto o : n.outputs) makeDirFor(o);
+        string log = logFile(n);
+        makeDirFor(log);
+        string cmd = "(" + n.cmd + ") > " + log + " 2>&1";
+        pid_t pid = fork();
+        if(pid == 0) {
+            execl("/bin/sh", "sh", "-c", cmd.c_str(), (char*) nullptr);
+            _exit(127);
+        }
+        if(pid < 0) {
+            cout << "Cannot fork : " << strerror(errno) << endl;
+            exit(1);
+        }
+        return pid;
+    }
+
+    //runs the waiting nodes with at most nJobs at once, returns the number of failed nodes
+    int execute(int nJobs)
+    {
+        int nRun = 0;
+        map<pid_t, int> running;
+        while(true) {
+            //the nodes after a failure are skipped, the ready ones are started
+            for(int i : order) {
+                node &n = nodes[i];
+                if(n.st != node::waiting) continue;
+                bool ready = true;
+                for(int d : n.deps) {
+                    auto s = nodes[d].st;
+                    if(s == node::failed || s == node::skipped) {
+                        n.st = node::skipped;
+                        cout << "[skip] " << n.name << " (" << nodes[d].name << " failed)" << endl;
+                        break;
+                    }
+                    if(s != node::done && s != node::upToDate) ready = false;
+                }
+                if(n.st == node::skipped || !ready || (int) running.size() >= nJobs) continue;
+                n.pid = launch(n);
+                n.st = node::running;
+                running[n.pid] = i;
+                cout << "[" << ++nRun << "] start " << n.name << endl;
+            }
+            if(running.empty()) break;
+
+            int wst;
+            pid_t pid = waitpid(-1, &wst, 0);
+            if(pid < 0) {
+                if(errno == EINTR) continue;
+                cout << "waitpid failed : " << strerror(errno) << endl;
+                exit(1);
+            }
+            if(!running.count(pid)) continue;
+            node &n = nodes[running.at(pid)];
+            running.erase(pid);
+            bool ok = WIFEXITED(wst) && WEXITSTATUS(wst) == 0;
+            for(auto o : n.outputs)
+                if(getMtime(o) < 0) ok = false;
+            n.st = ok ? node::done : node::failed;
+            cout << (ok ? "done   " : "FAILED ") << n.name << (ok ? "" : ", see " + logFile(n)) << endl;
+        }
+
+        int nFail = 0;
+        for(auto &n : nodes)
+            nFail += n.st == node::failed;
+        return nFail;
+    }
+
+    void print() const
+    {
+        const char *names[] = {"todo", "up-to-date", "running", "done", "failed", "skipped"};
+        for(int i : order) {
+            const node &n = nodes[i];
+            cout << "[" << names[n.st] << "] " << n.name << endl;
+            cout << "    " << n.cmd << endl;
+        }
+    }
+};
+
+
+int main(int argc, char** argv)
+{
+    string planFile;
+    int nJobs = -1;
+    bool dry = false, force = false;
+    for(int i = 1; i < argc; ++i) {
+        string a = argv[i];
+        if(a.rfind("--jobs=", 0) == 0) nJobs = atoi(a.substr(7).c_str());
+        else if(a == "--dry")   dry = true;
+        else if(a == "--force") force = true;
+        else if(a.rfind("--", 0) != 0 && planFile == "") planFile = a;
+        else {
+            planFile = "";
+            break;
+        }
+    }
+    if(planFile == "") {
+        cout << "Usage: " << argv[0] << " <plan file> [--jobs=N] [--dry] [--force]" << endl;
+        return 1;
+    }
+
+    runPlan plan;
+    plan.readPlan(planFile);
+    plan.build();
+    plan.checkStatus(force);
+
+    int nTodo = 0, nFresh = 0;
+    for(auto &n : plan.nodes) {
+        nTodo  += n.st == node::waiting;
+        nFresh += n.st == node::upToDate;
+    }
+    cout << plan.nodes.size() << " nodes, " << nFresh << " up to date, " << nTodo << " to run" << endl;
+    if(dry) {
+        plan.print();
+        return 0;
+    }
+
+    if(nJobs < 0) nJobs = atoi(plan.get1("jobs", "0").c_str());
+    if(nJobs <= 0) nJobs = max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+
+    time_t t0 = time(nullptr);
+    int nFail = plan.execute(nJobs);
+    cout << "Finished in " << time(nullptr) - t0 << " s, " << nFail << " failed" << endl;
+    return nFail ? 2 : 0;
+}
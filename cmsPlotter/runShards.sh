@@ -0,0 +1,39 @@
+#!/bin/bash
+#Sharded alphaS scan of calcTheory, the N shards run in parallel and are merged by mergeTheory
+#  ./runShards.sh [--mpi] <N> <out.root> [calcTheory options, e.g. --R=4 --pdf=CT14nnlo,NNPDF31_nnlo]
+#Without --mpi the shards are local processes (logs in <out>_shard<i>of<N>.log),
+#with --mpi they are started by mpirun and each takes its shard from the rank of the launcher
+#The shard files are kept, a shard can be rerun alone with ./calcTheory <options> --out=<out.root> --shard=<i>/<N>
+
+mpi=0
+if [ "$1" == "--mpi" ]; then mpi=1; shift; fi
+if [ $# -lt 2 ]; then
+    echo "Usage: $0 [--mpi] <N> <out.root> [calcTheory options]"
+    exit 1
+fi
+N=$1
+out=$2
+shift 2
+base=${out%.root}
+
+if [ $mpi == 1 ]; then
+    mpirun -np $N ./calcTheory "$@" --out=$out --shard=mpi || { echo "mpirun failed"; exit 1; }
+else
+    pids=()
+    for ((i = 0; i < N; ++i)); do
+        ./calcTheory "$@" --out=$out --shard=$i/$N > ${base}_shard${i}of${N}.log 2>&1 &
+        pids+=($!)
+    done
+    failed=0
+    for ((i = 0; i < N; ++i)); do
+        if ! wait ${pids[$i]}; then
+            echo "Shard $i failed, see ${base}_shard${i}of${N}.log"
+            failed=1
+        fi
+    done
+    [ $failed == 0 ] || exit 1
+fi
+
+shards=()
+for ((i = 0; i < N; ++i)); do shards+=(${base}_shard${i}of${N}.root); done
+./mergeTheory $out "${shards[@]}"
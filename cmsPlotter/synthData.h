@@ -0,0 +1,127 @@
+#ifndef synthData_H
+#define synthData_H
+
+//Synthetic data, theory and pdf variations for benchFitter and testPrune (no tables, LHAPDF sets or theory files needed)
+#include <random>
+
+#include "asFitter.h"
+
+struct synthConfig {
+    int nPoints = 200;  //data points (all rapidity bins)
+    int nSrc    = 34;   //data sources, the first ones are NPerr, NPsh and Lumi as in the tables
+    int nPdf    = 28;   //pdf eigenvectors (2 members each)
+    double minTime = 0.5;
+    unsigned seed  = 1;
+};
+
+//Synthetic cross section and its alphaS and scale dependence
+static double synthXsec(double pt, double yc, double as, int s)
+{
+    double x = 2*pt*cosh(yc) / 13000;
+    double xs = 1e9 * pow(pt/100, -5) * pow(max(1e-3, 1 - x), 6);
+    double kAs = 15 + 5*log(pt/100);
+    return xs * (1 + kAs*(as - 0.118)) * (1 + 0.02*(s - 3)/3.);
+}
+
+//Fill data, theory store and pdf variations of pdfName to fit
+inline void makeSynthetic(asFitter &fit, const synthConfig &cfg, TString pdfName)
+{
+    mt19937 gen(cfg.seed);
+    normal_distribution<double> gaus(0, 1);
+    uniform_real_distribution<double> uni(0, 1);
+
+    const int nY = 4;
+    int nPt = max(2, cfg.nPoints / nY);
+
+    ErrNames = {"NPerr", "NPsh", "Lumi"};
+    ErrNames.resize(min(3, cfg.nSrc));
+    for(int j = ErrNames.size(); j < cfg.nSrc; ++j)
+        ErrNames.push_back(Form("Src%d", j));
+
+    //source shape: amplitude, slope in log(pt), curvature, y dependence
+    vector<vector<double>> shape(cfg.nSrc);
+    for(auto &sh : shape)
+        sh = {0.003 + 0.015*uni(gen), 0.5*gaus(gen), 0.2*gaus(gen), 0.3*gaus(gen)};
+    auto srcVal = [&](int j, double pt, double yc) {
+        if(j < 2)  return 0.02 * (j+1) * 100 / pt; //NP
+        if(j == 2) return 0.025;                 //Lumi
+        const auto &sh = shape[j];
+        double l = log(pt/100);
+        return sh[0] * (1 + sh[1]*l + sh[2]*l*l) * (1 + sh[3]*yc);
+    };
+
+    //one draw of the sources for the data fluctuation
+    vector<double> draw(cfg.nSrc);
+    for(auto &r : draw) r = gaus(gen);
+
+    //binning
+    theoryStore &st = fit.thStores[pdfName];
+    st.yOff = {0};
+    st.edges.clear();
+    for(int y = 0; y < nY; ++y) {
+        double yc = 0.5*y + 0.25;
+        double ptMax = 3000 / cosh(yc);
+        for(int i = 0; i <= nPt; ++i)
+            st.edges.push_back(round(97 * pow(ptMax/97, double(i)/nPt)));
+        st.yOff.push_back(st.yOff.back() + nPt);
+    }
+    const vector<double> &asV = pdfAsVals.at(pdfName);
+    st.setLayout(asV, vector<int>(asV.size(), 1), 7);
+    st.allocate();
+
+    //pdf variations, relative to the central member
+    theoryStore &dl = fit.pdfDeltas[pdfName];
+    dl.setLayout({0.118}, {2*cfg.nPdf}, 7, st);
+    dl.allocate();
+    vector<vector<double>> pdfShape(cfg.nPdf);
+    for(auto &sh : pdfShape)
+        sh = {0.002 + 0.01*uni(gen), 1 + 2*uni(gen), 0.8 + 0.4*uni(gen)};
+
+    fit.data.clear();
+    for(int y = 0; y < nY; ++y)
+    for(int i = 0; i < nPt; ++i) {
+        int b = st.yOff[y] + i;
+        const double *e = st.edges.data() + st.yOff[y] + y;
+        double ptC = (e[i] + e[i+1]) / 2;
+        double yc  = 0.5*y + 0.25;
+        double x   = 2*ptC*cosh(yc) / 13000;
+
+        for(int iAs = 0; iAs < asV.size(); ++iAs)
+            for(int s = 0; s < 7; ++s)
+                st.vals[size_t(st.getSlot(iAs, s, 0))*st.nBinsTot() + b] = synthXsec(ptC, yc, asV[iAs], s);
+        for(int k = 0; k < cfg.nPdf; ++k) {
+            double v = pdfShape[k][0] * (1 + 20*pow(x, pdfShape[k][1]));
+            for(int s = 0; s < 7; ++s) {
+                dl.vals[size_t(dl.getSlot(0, s, 2*k))*dl.nBinsTot()   + b] =  v;
+                dl.vals[size_t(dl.getSlot(0, s, 2*k+1))*dl.nBinsTot() + b] = -v*pdfShape[k][2];
+            }
+        }
+
+        point p;
+        p.yMin = 0.5*y;
+        p.yMax = 0.5*y + 0.5;
+        p.ptMin = e[i];
+        p.ptMax = e[i+1];
+        p.errStat = min(0.3, 0.003 + 0.002*pow(ptC/100, 1.5));
+        p.errUnc = p.errUncOrg = 0.01;
+        p.errSys = p.errTot = 0;
+        double corr = 0;
+        for(int j = 0; j < cfg.nSrc; ++j) {
+            p.errs.push_back(srcVal(j, ptC, yc));
+            corr += p.errs.back() * draw[j];
+        }
+        p.sigma = synthXsec(ptC, yc, 0.1165, 3) * (1 + corr + p.errStat*gaus(gen));
+        p.th = 0;
+        fit.data.push_back(p);
+    }
+
+    pdfErrType et;
+    et.type  = pdfErrType::hessian;
+    et.nCore = 2*cfg.nPdf;
+    fit.pdfErrTypes[pdfName] = et;
+    fit.order = "nlo"; //no k-factors (they are read from files)
+    fit.thTag = "synth";
+    fit.Cut = [](const point &p) { return p.sigma != 0; };
+}
+
+#endif
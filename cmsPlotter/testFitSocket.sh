@@ -0,0 +1,106 @@
+#!/bin/bash
+#Test of fitServer and fitClient over a local socket, with the mock theory and synthetic data (no tables or pdf sets needed)
+#  make testFitSocket    (or ./testFitSocket.sh after make fitServer fitClient)
+#Sends ping, a valid query, invalid queries and the valid query again, checks the "ok" fields and the exit codes of fitClient
+#and that the server stops cleanly after shutdown. Everything is written to a temporary directory.
+
+dir=$(cd $(dirname $0) && pwd)
+tmp=$(mktemp -d /tmp/testFitSocket.XXXXXX)
+sock=$tmp/fit.sock
+srv=0
+cleanup() {
+    [ $srv != 0 ] && kill $srv 2> /dev/null
+    rm -rf $tmp
+}
+trap cleanup EXIT
+
+#Synthetic data table (format of readData), pt bins of the mock theory, 34 sources
+awk 'BEGIN {
+    n = split("97 114 133 153 174 196 220 245 272 300 330 362 395 430 468 507 548 592 638 686 737 790 846 905 967 1032 1101 1172 1248 1327 1410 1497 1588 1684 1784 1890 2000", e, " ")
+    print "*"
+    for(y = 0; y < 4; ++y)
+        for(i = 1; i < n && e[i+1] <= 7000/(exp(0.5*y)+exp(-0.5*y)); ++i) { #inside the mock binning
+            pt = sqrt(e[i]*e[i+1])
+            yc = 0.5*y+0.25
+            x  = pt*(exp(yc)+exp(-yc))/13000
+            s  = 1e9 * (pt/100)^-5 * (1-x)^6 * (1 - 0.05*yc)
+            line = sprintf("1 %g %g %g %g %g %g %g", 0.5*y, 0.5*y+0.5, e[i], e[i+1], s, 2, 1)
+            line = line sprintf(" %g %g %g %g %g", 2, -2, 1, -1, 2.5)
+            for(k = 0; k < 31; ++k) {
+                v = 0.5 + 0.1*k*log(pt/100)
+                line = line sprintf(" %g %g", v, -v)
+            }
+            print line
+        }
+}' > $tmp/table.txt
+
+#Unit NP and EW corrections, read by the server from theorFiles/corrs/np_ew.root of its working directory
+mkdir -p $tmp/theorFiles/corrs
+cat > $tmp/mkCorrs.C << 'EOF'
+void mkCorrs()
+{
+    TFile f("theorFiles/corrs/np_ew.root", "RECREATE");
+    for(TString c : {"np16", "ew16"})
+        for(int y = 0; y < 5; ++y) {
+            TH1D h(c + Form("_ak4_y%d", y), "", 1, 10, 10000);
+            h.SetBinContent(1, 1);
+            h.Write();
+        }
+}
+EOF
+(cd $tmp && root -l -b -q mkCorrs.C > /dev/null 2>&1)
+if [ ! -f $tmp/theorFiles/corrs/np_ew.root ]; then
+    echo "FAIL: corrections file not created (is ROOT set up?)"
+    exit 1
+fi
+
+(cd $tmp && exec $dir/fitServer --socket=$sock --theory=mock --data=$tmp/table.txt --order=nlo > $tmp/server.log 2>&1) &
+srv=$!
+for i in $(seq 300); do
+    [ -S $sock ] && break
+    sleep 0.1
+done
+if [ ! -S $sock ]; then
+    echo "FAIL: fit server did not start, log:"
+    cat $tmp/server.log
+    exit 1
+fi
+
+nFail=0
+#expect <exit code> <ok> <query...>
+expect() {
+    local code=$1 ok=$2
+    shift 2
+    local ans
+    ans=$($dir/fitClient --socket=$sock "$@")
+    local st=$?
+    if [ $st == $code ] && [[ "$ans" == *"\"ok\": $ok"* ]]; then
+        echo "ok   : $* -> exit $st"
+    else
+        echo "FAIL : $* -> exit $st (expected $code, ok $ok) : $ans"
+        nFail=$((nFail+1))
+    fi
+}
+
+expect 0 true  ping
+expect 0 true  pdf=CT14nnlo as=0.118 chi2=hera,simple
+expect 2 false pdf=NoSuchPdf as=0.118
+expect 2 false pdf=CT14nnlo wrongKey=1
+expect 2 false pdf=CT14nnlo as=0.5
+expect 0 true  pdf=CT14nnlo as=0.118 chi2=hera,simple
+expect 0 true  shutdown
+
+wait $srv
+st=$?
+srv=0
+if [ $st != 0 ]; then
+    echo "FAIL : server exit code $st"
+    nFail=$((nFail+1))
+fi
+
+if [ $nFail != 0 ]; then
+    echo "$nFail checks failed, server log:"
+    cat $tmp/server.log
+    exit 1
+fi
+echo "All checks passed"
@@ -0,0 +1,64 @@
+//Test of the source pruning on synthetic data (synthData.h): all experimental sources are pruned and merged,
+//the NP sources (NPerr, NPsh) and the pdf nuisances must survive and stay out of the uncorrelated error
+//  make testPrune
+#include "asFitter.h" //libAsFitter.so
+#include "synthData.h"
+
+int nFail = 0;
+
+void check(bool ok, TString what)
+{
+    cout << (ok ? "ok   : " : "FAIL : ") << what << endl;
+    if(!ok) ++nFail;
+}
+
+int main()
+{
+    synthConfig cfg;
+    cfg.nPoints = 80;
+    cfg.nSrc    = 12;
+    cfg.nPdf    = 5;
+    const TString pdfName = "CT14nnlo"; //only the alphaS grid of the set is used
+    asFitter fit;
+    makeSynthetic(fit, cfg, pdfName);
+    fit.fillTheory(pdfName, 0.118);
+    int nPdf = fit.data[0].thErrs.size();
+    vector<double> unc2(fit.data.size());
+    for(int i = 0; i < fit.data.size(); ++i) {
+        const auto &p = fit.data[i];
+        unc2[i] = p.errUnc*p.errUnc;
+        for(int j = 0; j < ErrNames.size(); ++j)
+            if(!ErrNames[j].BeginsWith("NP"))
+                unc2[i] += p.errs[j]*p.errs[j];
+    }
+
+    auto rank = fit.rankSources(pdfName);
+    bool npRanked = false;
+    for(auto r : rank)
+        npRanked = npRanked || ErrNames[r.second].BeginsWith("NP");
+    check(!npRanked, "NP sources are not ranked");
+    check(rank.size() == ErrNames.size() - 2, Form("%d of %d sources ranked", int(rank.size()), int(ErrNames.size())));
+
+    fit.pruneSources(pdfName, 1e30, true, false); //everything below the threshold
+    check(ErrNames.size() == 2 && ErrNames[0] == "NPerr" && ErrNames[1] == "NPsh", "only NPerr and NPsh remain");
+    bool sizesOk = true, uncOk = true;
+    for(int i = 0; i < fit.data.size(); ++i) {
+        const auto &p = fit.data[i];
+        sizesOk = sizesOk && p.errs.size() == ErrNames.size();
+        uncOk   = uncOk && abs(p.errUnc*p.errUnc - unc2[i]) < 1e-12 * unc2[i];
+    }
+    check(sizesOk, "point sources match ErrNames");
+    check(uncOk, "only the experimental sources are merged to the uncorrelated error");
+
+    fit.fillTheory(pdfName, 0.118);
+    check(fit.data[0].thErrs.size() == nPdf, Form("pdf nuisances kept (%d)", nPdf));
+    TVectorD sh = fit.getShiftsHERAall();
+    check(sh.GetNrows() == 2 + nPdf, "shifts of NP and pdf nuisances after the pruning");
+
+    if(nFail) {
+        cout << nFail << " checks failed" << endl;
+        return 1;
+    }
+    cout << "All checks passed" << endl;
+    return 0;
+}
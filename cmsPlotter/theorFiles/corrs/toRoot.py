@@ -4,12 +4,13 @@
 import ROOT
 
 import sys
+import os
 from math import sqrt
 
 def readTable(fName):
     sigmaTab = {}
     #Loop over files
-    fp = open(fName, 'r')
+    fp = open(os.path.join(os.path.dirname(os.path.abspath(__file__)), fName), 'r')
     for line in fp:
         line =  line.strip()
         if line == "":
@@ -72,11 +73,26 @@ def writeTable(corrTab, name):
         #print el
         #print bins
         
-fOut = ROOT.TFile('np_ew.root', 'RECREATE')
+#tables to convert (read next to this script), all by default to np_ew.root,
+#a subset only to another file, e.g. python theorFiles/corrs/toRoot.py --out=plan/corrs/np_ew.root np16_ak4 ew16_ak4 (runPlan)
+outName = 'np_ew.root'
+names = []
+for a in sys.argv[1:]:
+    if a.startswith('--out='):
+        outName = a[6:]
+    else:
+        names.append(a)
+if len(names) == 0:
+    names = ["ew15_ak4", "ew16_ak4", "ew16_ak7", "np15_ak4", "np16_ak4", "np16_ak7", "kFactorNLL_ak4", "kFactorNNLO_ak4", "kFactorNLL_ak7", "kFactorNNLO_ak7"]
+elif os.path.basename(outName) == 'np_ew.root' and os.path.dirname(os.path.abspath(outName)) == os.path.dirname(os.path.abspath(__file__)):
+    print("The shared np_ew.root is written only with all tables, use --out=<file> for a subset")
+    sys.exit(1)
+
+fOut = ROOT.TFile(outName, 'RECREATE')
 
 #fileName = "ew15_ak4"
 
-for n in ["ew15_ak4", "ew16_ak4", "ew16_ak7", "np15_ak4", "np16_ak4", "np16_ak7", "kFactorNLL_ak4", "kFactorNNLO_ak4", "kFactorNLL_ak7", "kFactorNNLO_ak7"]:
+for n in names:
     corrTab = readTable(n+'.txt')
     writeTable(corrTab, n)
 
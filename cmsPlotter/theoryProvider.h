@@ -0,0 +1,324 @@
+#ifndef theoryProvider_H
+#define theoryProvider_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <map>
+#include <iostream>
+#include <cstdlib>
+
+#include "TString.h"
+#include "TH1D.h"
+#include "pdfUnc.h"
+#include "instrument.h"
+
+//NO_FASTNLO: build without fastNLO and LHAPDF, only the mock theory is available
+#ifndef NO_FASTNLO
+#include "fastnlotk/fastNLOAlphas.h"
+#include "LHAPDF/LHAPDF.h"
+#endif
+
+//Source of the binned jet cross sections used by calcTheory and fitTheory, i.e. the part of fastNLOAlphas + LHAPDF which is used there
+//Backends: fastNLOProvider (fastNLO table evaluated with an LHAPDF set)
+//          mockProvider    (synthetic and deterministic, no tables or pdf sets needed)
+struct theoryProvider {
+    virtual ~theoryProvider() {}
+
+    virtual void setNLO() {} //LO + NLO contributions in publication units
+    virtual void setAlphasMz(double as) = 0;
+    virtual void setMember(int mem) = 0;
+    virtual void setScaleFactors(double muR, double muF) = 0;
+    virtual int  getNmembers() = 0;
+    virtual TString getPdfSetName() = 0;
+    virtual void setPdfSet(TString lhaName) = 0; //other pdf set with the same (already parsed) table, member 0
+    virtual pdfErrType getErrType() = 0; //uncertainty type of the pdf set
+
+    //Cross sections of all bins for the current settings,
+    //bin k spans [getBinLo(k,dim), getBinUp(k,dim)] with dim = 0 for |y| and dim = 1 for pt
+    virtual std::vector<double> calcCrossSection() = 0;
+    virtual int getNbins() = 0;
+    virtual double getBinLo(int k, int dim) = 0;
+    virtual double getBinUp(int k, int dim) = 0;
+};
+
+//(muR, muF) factors of the scale choices s = 0..6 stored in the theory files
+static const double scaleChoices[7][2] = { {1, 1}, {2, 2}, {0.5, 0.5}, {1, 2}, {1, 0.5}, {2, 1}, {0.5, 1} };
+
+
+//Cross sections xs of the provider bins as histograms in pt, one per rapidity bin (no errors)
+inline std::vector<TH1D*> getBinnedHistos(theoryProvider &fnlo, const std::vector<double> &xs)
+{
+    INSTR_SCOPE("histoConversion");
+    std::map<double, std::vector<double>> bins, xSec;
+    for(int k = 0; k < xs.size(); ++k) {
+        double etaDn = fnlo.getBinLo(k,0);
+        bins[etaDn].push_back(fnlo.getBinLo(k,1));
+        if(k == xs.size() - 1 || fnlo.getBinLo(k,0) != fnlo.getBinLo(k+1,0))
+            bins[etaDn].push_back(fnlo.getBinUp(k,1));
+        xSec[etaDn].push_back(xs[k]);
+    }
+
+    std::vector<TH1D*> hists;
+    for(const auto &obj : bins) {
+        double etaDn = obj.first;
+        const std::vector<double> &binning = obj.second;
+        TH1D *h = new TH1D(Form("%d", rand()), Form("%g", etaDn), binning.size()-1, binning.data());
+        for(int i = 0; i < xSec.at(etaDn).size(); ++i) {
+            h->SetBinContent(i+1, xSec.at(etaDn)[i]);
+            h->SetBinError(i+1, 0);
+        }
+        hists.push_back(h);
+    }
+    return hists;
+}
+
+
+//LHAPDF name of the set pdfName with alphaS = asI/1000
+inline TString getLHAname(TString pdfName, int asI)
+{
+    TString tag1, tag2;
+    if(pdfName == "CT14nlo") {
+        tag1 = "CT14nlo_as_0";
+    } else if(pdfName == "CT14nnlo") {
+        tag1 = "CT14nnlo_as_0";
+
+    } else if(pdfName == "HERAPDF20_NLO") {
+        tag1 = "HERAPDF20_NLO_ALPHAS_";
+    } else if(pdfName == "HERAPDF20_NNLO") {
+        tag1 = "HERAPDF20_NNLO_ALPHAS_";
+
+    } else if(pdfName == "NNPDF31_nlo") {
+        tag1 = "NNPDF31_nlo_as_0";
+    } else if(pdfName == "NNPDF31_nnlo") {
+        tag1 = "NNPDF31_nnlo_as_0";
+
+    } else if(pdfName == "ABMP16_5_nlo") {
+        tag1 = "ABMP16als";
+        tag2 = "_5_nlo";
+    } else if(pdfName == "ABMP16_5_nnlo") {
+        tag1 = "ABMP16als";
+        tag2 = "_5_nnlo";
+    } else if(pdfName == "MMHT2014nlo68cl" || "MMHT2014nnlo68cl") {
+        return pdfName;
+    }
+    else
+        exit(1);
+
+    TString whole = tag1 + Form("%d", asI) + tag2;
+
+    if(asI == 118) {
+        if(pdfName.Contains("CT14")) 
+            whole = pdfName;
+        else if(pdfName.Contains("HERAPDF20_"))
+            whole = pdfName + "_EIG";
+        else if(pdfName.Contains("NNPDF31_nlo"))
+            whole = "NNPDF31_nlo_as_0118_hessian";
+        else if(pdfName.Contains("NNPDF31_nnlo"))
+            whole = "NNPDF31_nnlo_as_0118_hessian";
+    }
+    if(pdfName.Contains("MMHT2014"))
+        whole = pdfName;
+
+    return whole;
+}
+
+
+#ifndef NO_FASTNLO
+//fastNLO table evaluated with an LHAPDF set
+struct fastNLOProvider : public theoryProvider {
+    fastNLOAlphas fnlo;
+
+    fastNLOProvider(TString table, TString lhaName) : fnlo(table.Data(), lhaName.Data(), 0) {}
+
+    void setNLO() override
+    {
+        fnlo.SetContributionON(fastNLO::kFixedOrder,0,true);
+        fnlo.SetContributionON(fastNLO::kFixedOrder,1,true);
+        fnlo.SetUnits(fastNLO::kPublicationUnits);
+    }
+    void setAlphasMz(double as) override { fnlo.SetAlphasMz(as, true); }
+    void setMember(int mem) override { fnlo.SetLHAPDFMember(mem); }
+    void setScaleFactors(double muR, double muF) override { fnlo.SetScaleFactorsMuRMuF(muR, muF); }
+    int  getNmembers() override { return fnlo.GetNPDFMembers(); }
+    TString getPdfSetName() override { return fnlo.GetLHAPDFFilename(); }
+    void setPdfSet(TString lhaName) override
+    {
+        fnlo.SetLHAPDFFilename(lhaName.Data());
+        fnlo.SetLHAPDFMember(0);
+    }
+    pdfErrType getErrType() override
+    {
+        const LHAPDF::PDFSet &set = LHAPDF::getPDFSet(getPdfSetName().Data());
+        return pdfErrType::fromInfo(set.errorType(), set.errorConfLevel(), set.size());
+    }
+
+    std::vector<double> calcCrossSection() override
+    {
+        INSTR_SCOPE("CalcCrossSection");
+        fnlo.CalcCrossSection();
+        return fnlo.GetCrossSection();
+    }
+    int getNbins() override { return fnlo.GetNObsBin(); }
+    double getBinLo(int k, int dim) override { return fnlo.GetObsBinLoBound(k, dim); }
+    double getBinUp(int k, int dim) override { return fnlo.GetObsBinUpBound(k, dim); }
+};
+#endif
+
+
+//Synthetic inclusive jet cross sections with the CMS binning (5 rapidity bins of 0.5, pt from 97 GeV),
+//the member counts and error types of the real pdf sets and realistic alphaS and scale dependence
+//All numbers follow from the table and set names, the same inputs give the same numbers on every machine
+struct mockProvider : public theoryProvider {
+    struct setInfo {
+        double as = 0.118;  //alphaS of the pdf set
+        TString errType = "hessian";
+        double cl = 68.27;
+        int nMem = 1;
+        TString family;     //set name without the alphaS part, used to seed the eigenvector shapes
+    };
+
+    TString table, lhaName;
+    setInfo info;
+    int R = 4;
+    double asMz = 0.118, muR = 1, muF = 1;
+    int mem = 0;
+    std::vector<double> yLo, ptLo, ptUp; //per bin
+    long long nCalls = 0;                //number of calcCrossSection calls
+
+    mockProvider(TString table_, TString lhaName_) : table(table_), lhaName(lhaName_)
+    {
+        info = getSetInfo(lhaName);
+        asMz = info.as;
+        R = table.Contains("5332") || table.Contains("ak7") || table.Contains("AK7") ? 7 : 4;
+
+        const double edges[] = {97, 114, 133, 153, 174, 196, 220, 245, 272, 300, 330, 362, 395, 430, 468, 507, 548, 592, 638, 686, 737,
+                                790, 846, 905, 967, 1032, 1101, 1172, 1248, 1327, 1410, 1497, 1588, 1684, 1784, 1890, 2000, 2116, 2238,
+                                2366, 2500, 2640, 2787, 2941, 3103, 3273, 3450};
+        const int nE = sizeof(edges)/sizeof(edges[0]);
+        for(int y = 0; y < 5; ++y) {
+            double ptMax = 3500 / cosh(0.5*y);
+            for(int i = 0; i+1 < nE && edges[i+1] <= ptMax; ++i) {
+                yLo.push_back(0.5*y);
+                ptLo.push_back(edges[i]);
+                ptUp.push_back(edges[i+1]);
+            }
+        }
+    }
+
+    //Error type and member count as in the LHAPDF metadata of the real sets
+    static setInfo getSetInfo(TString name)
+    {
+        setInfo si;
+        si.family = name;
+        //alphaS of the set from the name: ..._as_0116, ..._ALPHAS_116, ABMP16als116_...
+        for(TString tag : {"_as_0", "_ALPHAS_", "als"}) {
+            int i = name.Index(tag);
+            if(i < 0) continue;
+            TString num = name(i + tag.Length(), 3);
+            if(num.IsDigit()) {
+                si.as = num.Atoi() / 1000.;
+                si.family = name;
+                si.family.Replace(i + tag.Length(), 3, "");
+            }
+        }
+        bool asVar = std::abs(si.as - 0.118) > 1e-6;
+
+        if(name.Contains("CT14"))                { si.errType = "hessian";     si.cl = 90;    si.nMem = asVar ? 1 : 57; }
+        else if(name.Contains("HERAPDF20"))      { si.errType = "hessian";     si.cl = 68.27; si.nMem = name.Contains("_EIG") ? 29 : 1; }
+        else if(name.Contains("NNPDF31"))        { si.errType = name.Contains("hessian") ? "symmhessian" : "replicas"; si.nMem = 101; }
+        else if(name.Contains("ABMP16"))         { si.errType = "symmhessian"; si.cl = 68.27; si.nMem = 30; }
+        else if(name.Contains("MMHT2014"))       { si.errType = "hessian";     si.cl = name.Contains("90cl") ? 90 : 68.27; si.nMem = 51; }
+        else                                     { si.errType = "hessian";     si.cl = 68.27; si.nMem = 21; }
+        return si;
+    }
+
+    pdfErrType getErrType() override { return pdfErrType::fromInfo(info.errType, info.cl, info.nMem); }
+
+    void setAlphasMz(double as) override { asMz = as; }
+    void setMember(int m) override { mem = m; }
+    void setScaleFactors(double r, double f) override { muR = r; muF = f; }
+    int  getNmembers() override { return info.nMem; }
+    TString getPdfSetName() override { return lhaName; }
+    void setPdfSet(TString lhaName_) override
+    {
+        lhaName = lhaName_;
+        info = getSetInfo(lhaName);
+        asMz = info.as;
+        mem = 0;
+    }
+
+    int getNbins() override { return ptLo.size(); }
+    double getBinLo(int k, int dim) override { return dim == 0 ? yLo[k] : ptLo[k]; }
+    double getBinUp(int k, int dim) override { return dim == 0 ? yLo[k] + 0.5 : ptUp[k]; }
+
+    //Uniform number in [0,1) from the string and two integers (FNV-1a + splitmix64)
+    static double rnd(const TString &s, int a, int b)
+    {
+        uint64_t h = 1469598103934665603ULL;
+        for(int i = 0; i < s.Length(); ++i) {
+            h ^= (unsigned char) s[i];
+            h *= 1099511628211ULL;
+        }
+        h ^= uint64_t(a) * 0x9E3779B97F4A7C15ULL + uint64_t(b);
+        h += 0x9E3779B97F4A7C15ULL;
+        h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+        h ^= h >> 31;
+        return (h >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    //Relative shape of the pdf eigenvector k at momentum fraction x
+    double eigShape(int k, double x) const
+    {
+        double a = 0.002 + 0.01 * rnd(info.family, k, 0);
+        double p = 1 + 2 * rnd(info.family, k, 1);
+        return a * (1 + 20 * pow(x, p));
+    }
+
+    //Relative deviation of the current member from the central one
+    double memberShift(double x) const
+    {
+        if(mem == 0) return 0;
+        if(info.errType == "hessian") {
+            int k = (mem - 1) / 2;
+            return eigShape(k, x) * ((mem % 2) ? 1 : -(0.7 + 0.6*rnd(info.family, k, 2)));
+        }
+        if(info.errType == "symmhessian")
+            return eigShape(mem - 1, x) * (rnd(info.family, mem, 3) < 0.5 ? -1 : 1);
+        //replicas: gaussian combination of 10 eigenvectors
+        double v = 0;
+        for(int k = 0; k < 10; ++k) {
+            double g = -6;
+            for(int j = 0; j < 12; ++j)
+                g += rnd(info.family, mem, 100 + 12*k + j);
+            v += g * eigShape(k, x);
+        }
+        return v;
+    }
+
+    std::vector<double> calcCrossSection() override
+    {
+        INSTR_SCOPE("CalcCrossSection");
+        ++nCalls;
+        std::vector<double> xs(ptLo.size());
+        for(int k = 0; k < xs.size(); ++k) {
+            double pt = sqrt(ptLo[k] * ptUp[k]);
+            double yc = yLo[k] + 0.25;
+            double x  = 2*pt*cosh(yc) / 13000;
+            double l  = log(pt/100);
+            double v  = 1e9 * pow(pt/100, -5) * pow(std::max(1e-3, 1 - x), 6) * (1 - 0.05*yc) * (R == 7 ? 1.15 : 1);
+            v *= 1 + (15 + 5*l) * (asMz - 0.118);              //matrix elements
+            v *= 1 - 3 * (info.as - 0.118) * (1 + 5*x);        //alphaS of the pdf fit
+            v *= 1 - 0.06*log(muR)*(1 + 0.1*l) + 0.02*log(muF); //scale choice
+            v *= 1 + memberShift(x);
+            xs[k] = v;
+        }
+        return xs;
+    }
+};
+
+
+#endif
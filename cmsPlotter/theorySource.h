@@ -0,0 +1,418 @@
+#ifndef theorySource_H
+#define theorySource_H
+
+#include <vector>
+#include <map>
+#include <iostream>
+#include <fstream>
+#include <functional>
+#include <cmath>
+#include <cstdlib>
+
+#include "TH1D.h"
+#include "TFile.h"
+#include "TNamed.h"
+#include "TString.h"
+
+#include "tools.h"
+#include "theoryStore.h"
+#include "asSpline.h"
+#include "theoryProvider.h"
+
+//NLO predictions used by fitTheory: one pt histogram per rapidity for (pdf set, alphaS, scale choice s, pdf member)
+//The scale choices s = 0..6 are the scaleChoices of theoryProvider.h, the members > 0 are needed only at alphaS = 0.118
+//Backends: fileSource   (theory file written by calcTheory)
+//          storeSource  (columnar theoryStore file, converted once from another source and then only mapped)
+//          liveSource   (fastNLO or the mock evaluated on demand, every combination computed once)
+//          interpSource (another source at fewer alphaS values, spline in alphaS and reweighted pdf members)
+struct theorySource {
+    virtual ~theorySource() {}
+
+    //New histograms owned by the caller, empty if the combination is not available
+    virtual std::vector<TH1D*> read(TString pdfName, double as, int s, int mem) = 0;
+    //Number of pdf members including the central one
+    virtual int getNmembers(TString pdfName, double as) = 0;
+    //Pdf uncertainty type (pdfErrType::toString), "" if not known
+    virtual TString getErrType(TString pdfName) { return ""; }
+
+    static std::vector<TH1D*> cloneHistos(const std::vector<TH1D*> &hs)
+    {
+        std::vector<TH1D*> res;
+        for(auto h : hs)
+            res.push_back((TH1D*) h->Clone(Form("%d", rand())));
+        return res;
+    }
+};
+
+
+//Histograms pdfName_y<y>_as0<asI>_scale<s>_pdf<mem> of the file written by calcTheory (scanAsToFile)
+struct fileSource : public theorySource {
+    TFile *f;
+
+    fileSource(TFile *f_) : f(f_) {}
+
+    std::vector<TH1D*> read(TString pdfName, double as, int s, int mem) override
+    {
+        int asI = round(as*1000);
+        std::vector<TH1D*> vTh;
+        for(int y = 0; y < 5; ++y) {
+            TH1D *hTmp = (TH1D*) f->Get(pdfName + Form("_y%d_as0%d_scale%d_pdf%d", y, asI, s, mem));
+            if(!hTmp) {
+                for(auto h : vTh) delete h;
+                return {};
+            }
+            vTh.push_back((TH1D*) hTmp->Clone(Form("%d", rand())));
+            delete hTmp; //only the clone is kept
+        }
+        return vTh;
+    }
+
+    //Number of members stored by calcTheory
+    int getNmembers(TString pdfName, double as) override
+    {
+        if(round(as*1000) != 118) return 1;
+        if(pdfName.Contains("CT14"))             return 56+1;
+        if(pdfName.Contains("HERAPDF"))          return 28+1;
+        if(pdfName.Contains("NNPDF31"))          return 100+1;
+        if(pdfName.Contains("ABMP16_5"))         return 30;
+        if(pdfName.Contains("MMHT2014nnlo68cl")) return 50+1;
+        return 1;
+    }
+
+    //Written by calcTheory, missing in older files
+    TString getErrType(TString pdfName) override
+    {
+        TNamed *info = (TNamed*) f->Get(pdfName + "_errType");
+        return info ? TString(info->GetTitle()) : TString("");
+    }
+};
+
+
+//Theory evaluated by theoryProvider when asked for, without an intermediate file
+//There is one provider per LHAPDF set (created by make), the results are memoised
+struct liveSource : public theorySource {
+    std::function<theoryProvider*(TString lhaName)> make;
+    std::map<TString, theoryProvider*> provs; //by LHAPDF name
+    std::map<TString, std::vector<TH1D*>> cache;
+    long long nEval = 0; //number of calcCrossSection calls
+
+    liveSource(std::function<theoryProvider*(TString)> make_) : make(make_) {}
+    ~liveSource()
+    {
+        for(auto &p : provs) delete p.second;
+        for(auto &c : cache)
+            for(auto h : c.second) delete h;
+    }
+
+    theoryProvider &getProvider(TString pdfName, double as)
+    {
+        TString lha = getLHAname(pdfName, round(as*1000));
+        if(!provs.count(lha)) {
+            INSTR_SCOPE("tableLoad");
+            provs[lha] = make(lha);
+        }
+        return *provs.at(lha);
+    }
+
+    std::vector<TH1D*> read(TString pdfName, double as, int s, int mem) override
+    {
+        if(s < 0 || s >= 7 || mem >= getNmembers(pdfName, as)) return {};
+        TString key = pdfName + Form("_as%.4f_scale%d_pdf%d", as, s, mem);
+        if(!cache.count(key)) {
+            theoryProvider &p = getProvider(pdfName, as);
+            p.setAlphasMz(as);
+            p.setMember(mem);
+            p.setScaleFactors(scaleChoices[s][0], scaleChoices[s][1]);
+            cache[key] = getBinnedHistos(p, p.calcCrossSection());
+            ++nEval;
+            INSTR_COUNT("liveEvaluations", 1);
+        }
+        return cloneHistos(cache.at(key));
+    }
+
+    //As in the theory files, only the central member away from alphaS = 0.118
+    int getNmembers(TString pdfName, double as) override
+    {
+        if(round(as*1000) != 118) return 1;
+        return getProvider(pdfName, as).getNmembers();
+    }
+
+    TString getErrType(TString pdfName) override
+    {
+        return getProvider(pdfName, 0.118).getErrType().toString();
+    }
+};
+
+
+inline theorySource *makeTheorySource(TString spec, TString tag = "");
+
+//Columnar copy of the base source in a theoryStore file (one per pdf set, base spec and tag, dir/<pdfName>_<hash>.thstore),
+//filled with all alphaS values of pdfAsVals, 7 scales and all members at alphaS = 0.118 on the first use
+//and afterwards only mapped (also by other processes), the base source is then only created for the conversion
+struct storeSource : public theorySource {
+    TString dir, spec, tag; //spec of the base source
+    theorySource *base = nullptr;
+    std::map<TString, theoryStore*> stores;
+
+    storeSource(TString dir_, TString spec_, TString tag_) : dir(dir_), spec(spec_), tag(tag_) {}
+    ~storeSource() { for(auto &s : stores) delete s.second; delete base; }
+
+    //Stores of other base sources or tags in the same dir have other names
+    TString fileName(TString pdfName) const { return dir + "/" + pdfName + Form("_%08x.thstore", (spec + "|" + tag).Hash()); }
+
+    //The store is kept only if it was attached or converted completely
+    const theoryStore &getStore(TString pdfName)
+    {
+        if(stores.count(pdfName)) return *stores.at(pdfName);
+        theoryStore *st = new theoryStore;
+        try {
+            openStore(*st, pdfName);
+        }
+        catch(...) {
+            delete st;
+            throw;
+        }
+        stores[pdfName] = st;
+        return *st;
+    }
+
+    void openStore(theoryStore &st, TString pdfName)
+    {
+        TString key = fileName(pdfName);
+        if(st.attach(key)) return;
+        if(!base) base = makeTheorySource(spec, tag);
+
+        const std::vector<double> &asV = pdfAsVals.at(pdfName);
+        std::vector<int> nM;
+        for(double as : asV)
+            nM.push_back(base->getNmembers(pdfName, as));
+        std::vector<TH1D*> hBins = base->read(pdfName, asV[0], 0, 0);
+        if(hBins.empty())
+            fatalError("No theory of " + pdfName + " to convert");
+        st.setLayout(asV, nM, 7, hBins);
+        for(auto h : hBins) delete h;
+
+        if(!st.create(key)) { //converted by another process meanwhile
+            if(!st.attach(key))
+                fatalError("Theory store " + key + " can be neither created nor attached");
+            return;
+        }
+        std::cout << "Converting " << pdfName << " theory to " << key << std::endl;
+        try {
+            for(int iAs = 0; iAs < asV.size(); ++iAs)
+                for(int s = 0; s < 7; ++s)
+                    for(int m = 0; m < nM[iAs]; ++m) {
+                        std::vector<TH1D*> vTh = base->read(pdfName, asV[iAs], s, m);
+                        if(vTh.size() != st.nY()) {
+                            theoryStore::remove(key); //also without the throw
+                            fatalError("Theory of " + pdfName + Form(" as=%g scale%d pdf%d", asV[iAs], s, m) + " missing");
+                        }
+                        st.fill(iAs, s, m, vTh);
+                        for(auto h : vTh) delete h;
+                    }
+        }
+        catch(...) { //the unfinished store would keep the other processes waiting
+            theoryStore::remove(key);
+            throw;
+        }
+        std::ofstream(fileName(pdfName) + ".errType") << base->getErrType(pdfName) << std::endl;
+        st.publish();
+    }
+
+    std::vector<TH1D*> read(TString pdfName, double as, int s, int mem) override
+    {
+        const theoryStore &st = getStore(pdfName);
+        int iAs = st.findAsIndex(as);
+        if(iAs < 0 || s < 0 || s >= st.nScl || mem < 0 || mem >= st.nMem[iAs]) return {};
+        std::vector<TH1D*> vTh;
+        for(int y = 0; y < st.nY(); ++y) {
+            int n = st.yOff[y+1] - st.yOff[y];
+            const double *e = st.edges.data() + st.yOff[y] + y;
+            TH1D *h = new TH1D(Form("%d", rand()), "", n, e);
+            for(int i = 0; i < n; ++i)
+                h->SetBinContent(i+1, st.get(iAs, s, mem, st.yOff[y] + i));
+            vTh.push_back(h);
+        }
+        return vTh;
+    }
+
+    int getNmembers(TString pdfName, double as) override
+    {
+        const theoryStore &st = getStore(pdfName);
+        int iAs = st.findAsIndex(as);
+        return iAs >= 0 ? st.nMem[iAs] : 1;
+    }
+
+    TString getErrType(TString pdfName) override
+    {
+        getStore(pdfName);
+        std::string et;
+        std::ifstream(fileName(pdfName) + ".errType") >> et;
+        return et;
+    }
+};
+
+
+//Base source evaluated only at every nEvery-th alphaS of pdfAsVals (plus the last one and 0.118),
+//the central predictions in between come from the spline in alphaS.
+//The pdf members at any alphaS are reweighted from alphaS0 = 0.118: mem(as) = cnt(as) * mem(as0) / cnt(as0)
+//Together with liveSource this reduces the number of the fastNLO evaluations of a scan
+struct interpSource : public theorySource {
+    theorySource *base;
+    int nEvery;
+    std::map<TString, std::vector<double>> nodes;  //by pdfName
+    std::map<TString, asSpline> splines;           //by pdfName and scale
+    std::map<TString, std::vector<TH1D*>> binning; //by pdfName
+
+    interpSource(theorySource *base_, int nEvery_ = 2) : base(base_), nEvery(std::max(1, nEvery_)) {}
+    ~interpSource()
+    {
+        for(auto &b : binning)
+            for(auto h : b.second) delete h;
+        delete base;
+    }
+
+    const std::vector<double> &getNodes(TString pdfName)
+    {
+        std::vector<double> &nd = nodes[pdfName];
+        if(nd.empty()) {
+            const std::vector<double> &asV = pdfAsVals.at(pdfName);
+            for(int i = 0; i < asV.size(); ++i)
+                if(i % nEvery == 0 || i+1 == asV.size() || std::abs(asV[i] - 0.118) < 1e-6)
+                    nd.push_back(asV[i]);
+        }
+        return nd;
+    }
+
+    //Central prediction, from the base at the nodes and from the spline elsewhere
+    std::vector<TH1D*> central(TString pdfName, double as, int s)
+    {
+        const std::vector<double> &nd = getNodes(pdfName);
+        for(double a : nd)
+            if(std::abs(a - as) < 1e-6)
+                return base->read(pdfName, as, s, 0);
+        if(as < nd.front() - 1e-6 || as > nd.back() + 1e-6) return {};
+
+        TString key = pdfName + Form("_scale%d", s);
+        if(!splines.count(key)) {
+            std::vector<double> vals;
+            for(double a : nd) {
+                std::vector<TH1D*> vTh = base->read(pdfName, a, s, 0);
+                if(vTh.empty()) return {};
+                for(auto h : vTh) {
+                    for(int i = 1; i <= h->GetNbinsX(); ++i)
+                        vals.push_back(h->GetBinContent(i));
+                }
+                if(binning[pdfName].empty()) binning[pdfName] = vTh;
+                else for(auto h : vTh) delete h;
+            }
+            splines[key].init(nd, vals);
+        }
+        const asSpline &spl = splines.at(key);
+        std::vector<double> v(spl.nB);
+        spl.eval(as, v.data());
+
+        std::vector<TH1D*> vTh = cloneHistos(binning.at(pdfName));
+        int k = 0;
+        for(auto h : vTh)
+            for(int i = 1; i <= h->GetNbinsX(); ++i)
+                h->SetBinContent(i, v[k++]);
+        return vTh;
+    }
+
+    std::vector<TH1D*> read(TString pdfName, double as, int s, int mem) override
+    {
+        std::vector<TH1D*> cnt = central(pdfName, as, s);
+        if(mem == 0 || cnt.empty()) return cnt;
+        if(std::abs(as - 0.118) < 1e-6) {
+            for(auto h : cnt) delete h;
+            return base->read(pdfName, as, s, mem);
+        }
+
+        std::vector<TH1D*> mem0 = base->read(pdfName, 0.118, s, mem);
+        std::vector<TH1D*> cnt0 = base->read(pdfName, 0.118, s, 0);
+        if(mem0.size() == cnt.size() && cnt0.size() == cnt.size())
+            for(int y = 0; y < cnt.size(); ++y)
+                for(int i = 1; i <= cnt[y]->GetNbinsX(); ++i) {
+                    double c0 = cnt0[y]->GetBinContent(i);
+                    cnt[y]->SetBinContent(i, c0 != 0 ? cnt[y]->GetBinContent(i) * mem0[y]->GetBinContent(i) / c0 : 0);
+                }
+        else {
+            for(auto h : cnt) delete h;
+            cnt.clear();
+        }
+        for(auto h : mem0) delete h;
+        for(auto h : cnt0) delete h;
+        return cnt;
+    }
+
+    //The members away from alphaS = 0.118 can be reweighted, but as in the theory files only the central one is counted,
+    //so that a store of this source is not filled with all members at every alphaS
+    int getNmembers(TString pdfName, double as) override
+    {
+        if(round(as*1000) != 118) return 1;
+        return base->getNmembers(pdfName, 0.118);
+    }
+    TString getErrType(TString pdfName) override { return base->getErrType(pdfName); }
+};
+
+
+//Source from the specification, the prefixes can be combined:
+//  <file>.root            theory file of calcTheory
+//  live:<fastNLO table>   fastNLO + LHAPDF on demand
+//  mock[:<table name>]    mock theory on demand (table name selects R=7 if it contains ak7 or 5332)
+//  interp[<n>]:<spec>     <spec> at every n-th alphaS value (default 2), spline and reweighting in between
+//  store:<dir>:<spec>     columnar copy of <spec> in dir, e.g. store:/dev/shm:live:table.tab
+//The tag (jet radius and year of the theory) only enters the names of the store files
+inline theorySource *makeTheorySource(TString spec, TString tag)
+{
+    if(spec.BeginsWith("store:")) {
+        TString rest = spec(6, spec.Length());
+        int c = rest.First(':');
+        if(c < 0)
+            fatalError("Theory store " + spec + " without the base source, use store:<dir>:<spec>");
+        return new storeSource(rest(0, c), rest(c+1, rest.Length()), tag);
+    }
+    if(spec.BeginsWith("interp")) {
+        int c = spec.First(':');
+        TString n = spec(6, c - 6);
+        return new interpSource(makeTheorySource(spec(c+1, spec.Length()), tag), n == "" ? 2 : n.Atoi());
+    }
+    if(spec.BeginsWith("live:")) {
+#ifndef NO_FASTNLO
+        TString table = spec(5, spec.Length());
+        return new liveSource([table](TString lha) { return (theoryProvider*) new fastNLOProvider(table, lha); });
+#else
+        fatalError("Built without fastNLO, use mock instead of " + spec);
+#endif
+    }
+    if(spec == "mock" || spec.BeginsWith("mock:")) {
+        TString table = spec == "mock" ? TString("") : TString(spec(5, spec.Length()));
+        return new liveSource([table](TString lha) { return (theoryProvider*) new mockProvider(table, lha); });
+    }
+
+    TFile *f = TFile::Open(spec);
+    if(!f)
+        fatalError("Theory file " + spec + " does not exist.");
+    return new fileSource(f);
+}
+
+//Size and modification time of the file path, "" if it does not exist
+inline TString fileStamp(TString path)
+{
+    struct stat st;
+    if(stat(path.Data(), &st) != 0) return "";
+    return path + Form(":%lld:%lld", (long long) st.st_size, (long long) st.st_mtime);
+}
+
+//Identity of the theory of spec, changes with the files it reads (theory file, fastNLO table)
+inline TString theorySourceId(TString spec)
+{
+    TString id = spec;
+    for(auto t : splitString(spec, ':'))
+        id += "|" + fileStamp(t);
+    return id;
+}
+
+
+#endif
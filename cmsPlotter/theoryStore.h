@@ -0,0 +1,331 @@
+#ifndef theoryStore_H
+#define theoryStore_H
+
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+#include <cmath>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <signal.h>
+#include <dirent.h>
+
+#include "TH1D.h"
+#include "TString.h"
+
+#include "fatalError.h"
+
+//Decoded theory tensor [as][scale][pdfMember][y][ptBin] kept in one flat block.
+//The block lives either in private memory, in a POSIX shared-memory segment
+//(key "/name") or in a mmap'ed file (any other key), so that several fitTheory
+//processes can use a single copy of the theory.
+struct theoryStore {
+    struct header {
+        char    magic[8];
+        int32_t ready;   //set to 1 by the publisher once the block is complete
+        int32_t nAs, nScl, nY;
+        int32_t nEdges, nBinsTot, nSlots;
+        int64_t size;    //total size of the block in bytes
+        int32_t pid;     //process of the publisher
+        uint32_t srcId;  //identity of the theory the block was made from (0 if not checked)
+    };
+
+    //layout (small, always kept locally)
+    std::vector<double> asVals;  //alphaS values
+    std::vector<int>    nMem;    //number of pdf members for each alphaS
+    int nScl = 0;
+    std::vector<int>    yOff;    //offset of the first bin of each rapidity, size nY+1
+    std::vector<double> edges;   //pt edges, (nBins+1) per rapidity
+    std::vector<int>    slotBegin; //first slot of each alphaS
+
+    //values, either in own or in the mapped block
+    std::vector<double> own;
+    double *vals = nullptr;
+    void   *block = nullptr;
+    size_t  blockSize = 0;
+    uint32_t srcId = 0; //written by create, compared by attach if non-zero
+
+    theoryStore() {}
+    theoryStore(const theoryStore&) = delete;
+    theoryStore &operator=(const theoryStore&) = delete;
+    ~theoryStore() { unmap(); }
+
+    //Drop the mapping of the shared block (the values in own stay)
+    void unmap()
+    {
+        if(block) munmap(block, blockSize);
+        if(vals && own.empty()) vals = nullptr;
+        block = nullptr;
+        blockSize = 0;
+    }
+
+    int nY()       const { return yOff.size() - 1; }
+    int nBinsTot() const { return yOff.back(); }
+    int nSlots()   const { return slotBegin.back(); }
+
+    //Set the layout, binning is taken from histograms (one per rapidity)
+    void setLayout(const std::vector<double> &asV, const std::vector<int> &nM, int nS, const std::vector<TH1D*> &hY)
+    {
+        yOff = {0};
+        edges.clear();
+        for(auto h : hY) {
+            for(int i = 1; i <= h->GetNbinsX()+1; ++i)
+                edges.push_back(h->GetBinLowEdge(i));
+            yOff.push_back(yOff.back() + h->GetNbinsX());
+        }
+        setLayout(asV, nM, nS);
+    }
+
+    //Set the layout, binning is copied from another store
+    void setLayout(const std::vector<double> &asV, const std::vector<int> &nM, int nS, const theoryStore &bins)
+    {
+        yOff  = bins.yOff;
+        edges = bins.edges;
+        setLayout(asV, nM, nS);
+    }
+
+    void setLayout(const std::vector<double> &asV, const std::vector<int> &nM, int nS)
+    {
+        asVals = asV;
+        nMem   = nM;
+        nScl   = nS;
+        slotBegin = {0};
+        for(int m : nMem)
+            slotBegin.push_back(slotBegin.back() + m*nScl);
+    }
+
+    //Allocate private storage for the values
+    void allocate()
+    {
+        own.assign(size_t(nSlots())*nBinsTot(), 0.);
+        vals = own.data();
+    }
+
+    //Index of alphaS value as, -1 if not in the store
+    int findAsIndex(double as) const
+    {
+        for(int i = 0; i < asVals.size(); ++i)
+            if(std::abs(asVals[i] - as) < 1e-6) return i;
+        return -1;
+    }
+
+    int getAsIndex(double as) const
+    {
+        int i = findAsIndex(as);
+        if(i >= 0) return i;
+        fatalError(Form("alphaS %g not in the theory store", as));
+    }
+
+    //Global bin containing pt for rapidity bin y, -1 if outside
+    int findBin(int y, double pt) const
+    {
+        if(y < 0 || y >= nY()) return -1;
+        const double *e = edges.data() + yOff[y] + y;
+        int n = yOff[y+1] - yOff[y];
+        if(pt < e[0] || pt >= e[n]) return -1;
+        int i = std::upper_bound(e, e+n+1, pt) - e - 1;
+        return yOff[y] + i;
+    }
+
+    int getSlot(int iAs, int s, int mem) const { return slotBegin[iAs] + s*nMem[iAs] + mem; }
+
+    double get(int iAs, int s, int mem, int gBin) const
+    {
+        return vals[size_t(getSlot(iAs, s, mem))*nBinsTot() + gBin];
+    }
+
+    //Copy histogram contents (one per rapidity) to the given slot
+    void fill(int iAs, int s, int mem, const std::vector<TH1D*> &hY)
+    {
+        double *v = vals + size_t(getSlot(iAs, s, mem))*nBinsTot();
+        for(int y = 0; y < nY(); ++y)
+            for(int i = 0; i < yOff[y+1]-yOff[y]; ++i)
+                v[yOff[y]+i] = hY[y]->GetBinContent(i+1);
+    }
+
+
+    //Shared block handling
+    static bool isShm(TString key) { return key.Length() > 1 && key[0] == '/' && key.Last('/') == 0; }
+    static size_t align8(size_t n) { return (n + 7) / 8 * 8; }
+
+    size_t layoutSize() const
+    {
+        size_t s = align8(sizeof(header));
+        s += sizeof(double)*asVals.size() + sizeof(double)*edges.size();
+        s += align8(sizeof(int32_t)*(nMem.size() + yOff.size()));
+        s += sizeof(double)*size_t(nSlots())*nBinsTot();
+        return s;
+    }
+
+    //Create the block exclusively; returns false if it already exists
+    //After success the values are writable and publish() must be called once they are filled
+    bool create(TString key)
+    {
+        unmap();
+        int fd = isShm(key) ? shm_open(key.Data(), O_CREAT|O_EXCL|O_RDWR, 0644)
+                            :      open(key.Data(), O_CREAT|O_EXCL|O_RDWR, 0644);
+        if(fd < 0) {
+            if(errno == EEXIST) return false;
+            fatalError("Cannot create theory store " + key + " : " + strerror(errno));
+        }
+        blockSize = layoutSize();
+        if(ftruncate(fd, blockSize) != 0) {
+            TString err = strerror(errno);
+            close(fd);
+            remove(key);
+            fatalError("Cannot resize theory store " + key + " : " + err);
+        }
+        block = mmap(nullptr, blockSize, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if(block == MAP_FAILED) {
+            block = nullptr;
+            remove(key);
+            fatalError("Cannot map theory store " + key);
+        }
+
+        header *h = (header*) block;
+        memcpy(h->magic, "FPTHEOR2", 8);
+        h->ready = 0;
+        h->pid = getpid();
+        h->srcId = srcId;
+        h->nAs = asVals.size();
+        h->nScl = nScl;
+        h->nY = nY();
+        h->nEdges = edges.size();
+        h->nBinsTot = nBinsTot();
+        h->nSlots = nSlots();
+        h->size = blockSize;
+
+        char *p = (char*)block + align8(sizeof(header));
+        memcpy(p, asVals.data(), sizeof(double)*asVals.size()); p += sizeof(double)*asVals.size();
+        memcpy(p, edges.data(),  sizeof(double)*edges.size());  p += sizeof(double)*edges.size();
+        int32_t *pi = (int32_t*) p;
+        for(int m : nMem) *pi++ = m;
+        for(int o : yOff) *pi++ = o;
+        p += align8(sizeof(int32_t)*(nMem.size() + yOff.size()));
+        vals = (double*) p;
+        own.clear();
+        return true;
+    }
+
+    //Mark the block as complete and make it read-only
+    void publish()
+    {
+        __atomic_store_n(&((header*)block)->ready, 1, __ATOMIC_RELEASE);
+        mprotect(block, blockSize, PROT_READ);
+    }
+
+    //Attach to an existing block (waits until the publisher is done); returns false if it does not exist
+    //or if its publisher died before completing it (the block is then removed and can be created again)
+    bool attach(TString key, int timeout = 1800)
+    {
+        unmap(); //an earlier mapping, e.g. of a replaced block
+        int fd = isShm(key) ? shm_open(key.Data(), O_RDONLY, 0) : open(key.Data(), O_RDONLY);
+        if(fd < 0) return false;
+
+        //the segment may be just created by the publisher, wait for its final size
+        struct stat st;
+        for(int t = 0; ; ++t) {
+            fstat(fd, &st);
+            if(st.st_size >= sizeof(header)) break;
+            if(t > timeout) { close(fd); fatalError("Theory store " + key + " is empty"); }
+            sleep(1);
+        }
+        blockSize = st.st_size;
+        block = mmap(nullptr, blockSize, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if(block == MAP_FAILED) {
+            block = nullptr;
+            fatalError("Cannot map theory store " + key);
+        }
+
+        const header *h = (const header*) block;
+        for(int t = 0; !__atomic_load_n(&h->ready, __ATOMIC_ACQUIRE); ++t) {
+            if(t == 0) std::cout << "Waiting for theory store " << key << std::endl;
+            if(kill(h->pid, 0) != 0 && errno == ESRCH) {
+                std::cout << "Publisher of theory store " << key << " died, the store is removed" << std::endl;
+                if(isSame(key, st.st_ino)) remove(key); //not if another process already replaced it
+                unmap();
+                return false;
+            }
+            if(t > timeout) {
+                unmap();
+                fatalError("Theory store " + key + " never completed, remove it");
+            }
+            sleep(1);
+        }
+        if(memcmp(h->magic, "FPTHEOR2", 8) != 0 || h->size != blockSize) {
+            unmap();
+            fatalError("Theory store " + key + " is corrupted or of an older version, remove it");
+        }
+        if(srcId && h->srcId != srcId) {
+            unmap();
+            fatalError("Theory store " + key + " was made from another theory, remove it");
+        }
+
+        const char *p = (const char*)block + align8(sizeof(header));
+        asVals.assign((const double*)p, (const double*)p + h->nAs); p += sizeof(double)*h->nAs;
+        edges.assign((const double*)p, (const double*)p + h->nEdges); p += sizeof(double)*h->nEdges;
+        const int32_t *pi = (const int32_t*) p;
+        nMem.assign(pi, pi + h->nAs);  pi += h->nAs;
+        yOff.assign(pi, pi + h->nY+1);
+        p += align8(sizeof(int32_t)*(h->nAs + h->nY+1));
+        nScl = h->nScl;
+        slotBegin = {0};
+        for(int m : nMem)
+            slotBegin.push_back(slotBegin.back() + m*nScl);
+        vals = (double*) p;
+        own.clear();
+        return true;
+    }
+
+    //Remove the shared block (the mapped copies stay valid)
+    static void remove(TString key)
+    {
+        if(isShm(key)) shm_unlink(key.Data());
+        else           unlink(key.Data());
+    }
+
+    //True if key still names the block with inode ino
+    static bool isSame(TString key, ino_t ino)
+    {
+        int fd = isShm(key) ? shm_open(key.Data(), O_RDONLY, 0) : open(key.Data(), O_RDONLY);
+        if(fd < 0) return false;
+        struct stat st;
+        bool same = fstat(fd, &st) == 0 && st.st_ino == ino;
+        close(fd);
+        return same;
+    }
+
+    //Remove all blocks with keys <prefix>_... (POSIX shm segments are listed in /dev/shm), returns their number
+    static int removeAll(TString prefix)
+    {
+        TString dir  = isShm(prefix) ? TString("/dev/shm") : TString(".");
+        TString base = isShm(prefix) ? TString(prefix(1, prefix.Length())) : prefix;
+        if(!isShm(prefix) && prefix.Last('/') >= 0) {
+            dir  = prefix(0, prefix.Last('/'));
+            base = prefix(prefix.Last('/') + 1, prefix.Length());
+        }
+        DIR *d = opendir(dir.Data());
+        if(!d) return 0;
+        int n = 0;
+        while(dirent *e = readdir(d)) {
+            TString name = e->d_name;
+            if(!name.BeginsWith(base + "_")) continue; //the stores of asFitter are <prefix>_<pdf>_<tag>_...
+            TString key = isShm(prefix) ? "/" + name : dir + "/" + name;
+            remove(key);
+            std::cout << "Removed theory store " << key << std::endl;
+            ++n;
+        }
+        closedir(d);
+        return n;
+    }
+};
+
+
+#endif
@@ -4,10 +4,13 @@
 #include "TGraphAsymmErrors.h"
 #include "TH1D.h"
 #include "TFile.h"
+#include "rebin.h" //libAsFitter.so
 #include <vector>
 #include <map>
 #include <algorithm>
 #include <cassert>
+#include <sstream>
+#include <string>
 
 
 const std::vector<TString> yBins = {"|y| < 0.5",  "0.5 < |y| < 1.0",  "1.0 < |y| < 1.5", "1.5 < |y| < 2.0", "2.0 < |y| < 2.5"};
@@ -36,6 +39,18 @@ inline void myAssertFun(bool cond, std::string str,   int line, std::string file
 #endif
 
 
+//Split string to pieces, e.g. "nlo,nll" -> {"nlo", "nll"}
+inline std::vector<TString> splitString(TString str, char delim)
+{
+    std::vector<TString> v;
+    std::stringstream ss(str.Data());
+    std::string item;
+    while(std::getline(ss, item, delim))
+        if(item != "") v.push_back(item.c_str());
+    return v;
+}
+
+
 static const std::vector<double> ptBinsAs = {97, 174, 272, 395, 548, 737, 967, 1248, 1588, 2000, 3103};
 
 static const std::map<TString, std::vector<double> > pdfAsVals =  {
@@ -58,10 +73,17 @@ static const std::map<TString, std::vector<double> > pdfAsVals =  {
 
 
 
+//File of the NP + EW corrections and k-factors, to be set before their first use (fitTheory --corrs=<file>)
+inline TString &corrFileName()
+{
+    static TString fName = "theorFiles/corrs/np_ew.root";
+    return fName;
+}
+
 //Apply NP + EW corrections to theory
 inline void applyNPEW(TH1D *h, int y,  TString Tag)
 {
-    static TFile *fNPEW  = TFile::Open("theorFiles/corrs/np_ew.root");  //NP+EW corrections
+    static TFile *fNPEW  = TFile::Open(corrFileName());  //NP+EW corrections
 
     int year = Tag.Contains("15") ? 15 : 16;
 
@@ -93,31 +115,17 @@ inline void applyNPEW(TH1D *h, int y,  TString Tag)
         std::exit(0);
     }
 
-    for(int i = 1; i <= h->GetNbinsX(); ++i) {
-        double pt  = h->GetBinCenter(i);
-        double v   = h->GetBinContent(i);
-        double err = h->GetBinError(i);
-
-        int iNP = hNP->FindBin(pt);
-        int iEW = hEW->FindBin(pt);
-
-        double np = hNP->GetBinContent(iNP);
-        double ew = hEW->GetBinContent(iEW);
-
-        v   *= np * ew;
-        err *= np * ew;
-
-        h->SetBinContent(i, v);
-        h->SetBinError(i, err);
-    }
+    //corrections averaged over the pt bins of h (overlap weighted)
+    getRebinMatrix(hNP, h, rebinMatrix::average).multiply(h, hNP);
+    getRebinMatrix(hEW, h, rebinMatrix::average).multiply(h, hEW);
     //fNPEW->Close();
 }
 
 
 //Apply NNLO or NLL k-factor
-void applyKfactor(TH1D *h, int y,  TString Tag)
+inline void applyKfactor(TH1D *h, int y,  TString Tag)
 {
-    static TFile *fNPEW  = TFile::Open("theorFiles/corrs/np_ew.root");  //NP+EW corrections
+    static TFile *fNPEW  = TFile::Open(corrFileName());  //NP+EW corrections
 
     TH1D *hCorr = dynamic_cast<TH1D*>( fNPEW->Get(Tag + Form("_y%d",  y)));
     if(!hCorr) {
@@ -125,25 +133,11 @@ void applyKfactor(TH1D *h, int y,  TString Tag)
         std::exit(0);
     }
 
-    for(int i = 1; i <= h->GetNbinsX(); ++i) {
-        double pt  = h->GetBinCenter(i);
-        double v   = h->GetBinContent(i);
-        double err = h->GetBinError(i);
-
-        int iCorr = hCorr->FindBin(pt);
-
-        double corr = hCorr->GetBinContent(iCorr);
-
-        v   *= corr;
-        err *= corr;
-
-        h->SetBinContent(i, v);
-        h->SetBinError(i, err);
-    }
+    getRebinMatrix(hCorr, h, rebinMatrix::average).multiply(h, hCorr);
     //fNPEW->Close();
 }
 
-TGraphAsymmErrors *getBand(TH1D *hCnt, TH1D *hUp, TH1D *hDn)
+inline TGraphAsymmErrors *getBand(TH1D *hCnt, TH1D *hUp, TH1D *hDn)
 {
     hUp->Divide(hCnt);
     hDn->Divide(hCnt);